@@ -0,0 +1,245 @@
+/**
+ * @file ann_eval.cpp
+ * @author Siddarth Sheth
+ * @brief Recall and throughput of ApxNNSearch on standard ANN datasets.
+ *
+ * Usage:
+ *   ann_eval base query [groundtruth] [--k K] [--eps e1,e2,...] [--n max_n] [--q max_q]
+ *
+ * base and query are fvecs, bvecs, fbin or u8bin files and groundtruth an
+ * ivecs or ibin file of the nearest base ids of every query. Without a
+ * ground-truth file, or when --n truncates the base set, the ground truth is
+ * computed by brute force.
+ *
+ * The index is built once with greedy_tree and fast_gt. Then, for every eps,
+ * all queries are answered one at a time and as a batch (over a greedy tree
+ * of the queries, whose build time is reported separately). The search
+ * returns one neighbor, so the recall reported is recall@1: a query counts as
+ * a hit if the returned point is no farther than its true nearest neighbor, up
+ * to a relative tolerance of 1e-3, as in ann-benchmarks. --k K only moves that
+ * threshold to the Kth true neighbor; the column is then labeled hit@K, as it
+ * is not recall@K. Distances are L2.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include "balltree.hpp"
+#include "fast_search_impl.hpp"
+#include "loaders.hpp"
+#include "utils.hpp"
+#include "counting_metric.hpp"
+
+struct EvalConfig {
+    std::string base, query, groundtruth;
+    std::size_t k = 1;
+    std::vector<double> eps = {0, 0.1, 0.5, 1, 2};
+    std::size_t max_n = std::numeric_limits<std::size_t>::max();
+    std::size_t max_q = std::numeric_limits<std::size_t>::max();
+};
+
+// Relative slack on the kth true distance, to absorb float to double rounding.
+constexpr double recall_tolerance = 1e-3;
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Distance from every query to its kth nearest base point.
+ *
+ * Must be called with the base points in file order, before greedy_tree permutes them.
+ */
+template <std::size_t d>
+std::vector<double> kth_distances(const std::vector<std::array<double, d>>& base,
+                                  const std::vector<std::array<double, d>>& queries,
+                                  const EvalConfig& config) {
+    L2Metric metric;
+    std::vector<double> kth(queries.size());
+    bool use_file = !config.groundtruth.empty() && config.max_n >= vecs_size(config.base);
+    if (use_file) {
+        auto ids = load_neighbors(config.groundtruth, config.k, queries.size());
+        if (ids.size() < queries.size() || ids[0].size() < config.k)
+            throw std::runtime_error("ann_eval: " + config.groundtruth + " has too few rows or neighbors");
+        for (std::size_t i = 0; i < queries.size(); i++)
+            kth[i] = metric.dist(queries[i], base.at(ids[i][config.k - 1]));
+        return kth;
+    }
+
+    std::cout << "computing ground truth by brute force" << std::endl;
+    std::vector<double> dists(base.size());
+    for (std::size_t i = 0; i < queries.size(); i++) {
+        for (std::size_t j = 0; j < base.size(); j++)
+            dists[j] = metric.dist(queries[i], base[j]);
+        std::nth_element(dists.begin(), dists.begin() + (config.k - 1), dists.end());
+        kth[i] = dists[config.k - 1];
+    }
+    return kth;
+}
+
+template <std::size_t d>
+void evaluate(const EvalConfig& config) {
+    using Pt = std::array<double, d>;
+    L2Metric metric;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Pt> base = load_points<d>(config.base, config.max_n);
+    std::vector<Pt> queries = load_points<d>(config.query, config.max_q);
+    std::cout << "loaded " << base.size() << " points and " << queries.size()
+              << " queries of dimension " << d << " in " << seconds_since(start) << " s" << std::endl;
+    if (base.size() < config.k)
+        throw std::runtime_error("ann_eval: fewer base points than k");
+
+    std::vector<double> kth = kth_distances(base, queries, config);
+    auto is_hit = [&](std::size_t i, const Pt& p) {
+        return metric.dist(queries[i], p) <= kth[i] * (1 + recall_tolerance);
+    };
+
+    // build
+    start = std::chrono::steady_clock::now();
+    auto tree = greedy_tree(base, metric);
+    double tree_time = seconds_since(start);
+    GTPoints<d> G;
+    GTData aux;
+    start = std::chrono::steady_clock::now();
+    fast_gt(tree.get(), G, aux);
+    double gt_time = seconds_since(start);
+
+    MemoryReport report;
+    memory_usage(tree.get(), report);
+    memory_usage(G, aux, report);
+    std::cout << "greedy_tree: " << tree_time << " s, fast_gt: " << gt_time << " s\n";
+    display_memory(report);
+    tree.reset();
+
+    // the batch search traverses a greedy tree of the queries; its positions are mapped back to query ids
+    std::vector<Pt> query_order = queries;
+    start = std::chrono::steady_clock::now();
+    GTPoints<d> Q;
+    GTData aux_q;
+    fast_gt(greedy_tree(query_order, metric).get(), Q, aux_q);
+    double query_tree_time = seconds_since(start);
+    std::cout << "query tree: " << query_tree_time << " s\n";
+    std::vector<std::size_t> query_id(Q.size());
+    {
+        std::vector<std::size_t> order(queries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return queries[a] < queries[b]; });
+        for (std::size_t i = 0; i < Q.size(); i++) {
+            auto it = std::lower_bound(order.begin(), order.end(), Q[i].first,
+                                       [&](std::size_t a, const Pt& p) { return queries[a] < p; });
+            query_id[i] = *it;
+        }
+    }
+
+    std::cout << "\n" << std::setw(8) << "eps" << std::setw(8) << "mode"
+              << std::setw(12) << (config.k == 1 ? "recall@1" : "hit@" + std::to_string(config.k))
+              << std::setw(14) << "QPS" << std::setw(14) << "evals/query" << "\n";
+    ApxNNSearch<d, L2Metric> search(G, aux, metric);
+    std::uint64_t evals = 0;
+    CountingMetric<L2Metric> counting(&evals);
+    ApxNNSearch<d, CountingMetric<L2Metric>> counted(G, aux, counting);
+
+    for (double e : config.eps) {
+        // one query at a time
+        std::vector<std::size_t> nns(queries.size());
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < queries.size(); i++)
+            nns[i] = search(queries[i], e);
+        double single_time = seconds_since(start);
+        std::size_t hits = 0;
+        for (std::size_t i = 0; i < queries.size(); i++)
+            hits += is_hit(i, G[nns[i]].first);
+        evals = 0;
+        for (auto& q : queries)
+            counted(q, e);
+        std::cout << std::setw(8) << e << std::setw(8) << "single"
+                  << std::setw(12) << double(hits) / queries.size()
+                  << std::setw(14) << queries.size() / single_time
+                  << std::setw(14) << double(evals) / queries.size() << "\n";
+
+        // batch
+        start = std::chrono::steady_clock::now();
+        search(Q, aux_q, nns, e);
+        double batch_time = seconds_since(start);
+        hits = 0;
+        for (std::size_t i = 0; i < Q.size(); i++)
+            hits += is_hit(query_id[i], G[nns[i]].first);
+        evals = 0;
+        counted(Q, aux_q, nns, e);
+        std::cout << std::setw(8) << e << std::setw(8) << "batch"
+                  << std::setw(12) << double(hits) / Q.size()
+                  << std::setw(14) << Q.size() / batch_time
+                  << std::setw(14) << double(evals) / Q.size() << std::endl;
+    }
+}
+
+/**
+ * @brief Call evaluate<d> for the d among ds that equals dim.
+ */
+template <std::size_t... ds>
+bool dispatch(std::size_t dim, const EvalConfig& config, std::index_sequence<ds...>) {
+    return ((dim == ds ? (evaluate<ds>(config), true) : false) || ...);
+}
+
+// Dimensions of common ANN datasets; add to this list to evaluate others.
+using SupportedDims = std::index_sequence<2, 3, 8, 16, 20, 25, 32, 50, 64, 96, 100, 128, 200, 256, 384, 768, 784, 960>;
+
+static std::vector<double> parse_list(const std::string& s) {
+    std::vector<double> values;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        values.push_back(std::stod(item));
+    return values;
+}
+
+int main(int argc, char** argv) {
+    EvalConfig config;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--k")
+            config.k = std::stoul(argv[++i]);
+        else if (i + 1 < argc && arg == "--eps")
+            config.eps = parse_list(argv[++i]);
+        else if (i + 1 < argc && arg == "--n")
+            config.max_n = std::stoul(argv[++i]);
+        else if (i + 1 < argc && arg == "--q")
+            config.max_q = std::stoul(argv[++i]);
+        else
+            files.push_back(arg);
+    }
+    if (files.size() < 2 || files.size() > 3 || config.k == 0) {
+        std::cerr << "usage: " << argv[0]
+                  << " base query [groundtruth] [--k K] [--eps e1,e2,...] [--n max_n] [--q max_q]\n";
+        return 1;
+    }
+    config.base = files[0];
+    config.query = files[1];
+    if (files.size() == 3)
+        config.groundtruth = files[2];
+
+    try {
+        std::size_t dim = vecs_dim(config.base);
+        if (vecs_dim(config.query) != dim)
+            throw std::runtime_error("ann_eval: base and query dimensions differ");
+        if (!dispatch(dim, config, SupportedDims()))
+            throw std::runtime_error("ann_eval: dimension " + std::to_string(dim) + " is not in SupportedDims");
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
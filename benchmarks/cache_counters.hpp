@@ -0,0 +1,97 @@
+/**
+ * @file cache_counters.hpp
+ * @author Siddarth Sheth
+ * @brief Hardware counters of L1 data and last-level cache misses, for benchmarks.
+ */
+
+#ifndef CACHE_COUNTERS_H
+#define CACHE_COUNTERS_H
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief L1 data cache read misses and last-level cache misses of the calling
+ * thread in user space, read with perf_event_open.
+ *
+ * The counters cannot be opened without a PMU, as in many virtual machines, or
+ * with /proc/sys/kernel/perf_event_paranoid above 2. valid() is then false and
+ * measure() leaves its outputs at 0.
+ */
+class CacheCounters {
+public:
+    CacheCounters() {
+#ifdef __linux__
+        l1d_fd = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                                          | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        llc_fd = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+    }
+
+    ~CacheCounters() {
+#ifdef __linux__
+        if (l1d_fd >= 0)
+            close(l1d_fd);
+        if (llc_fd >= 0)
+            close(llc_fd);
+#endif
+    }
+
+    CacheCounters(const CacheCounters&) = delete;
+    CacheCounters& operator=(const CacheCounters&) = delete;
+
+    bool valid() const { return l1d_fd >= 0 && llc_fd >= 0; }
+
+    /**
+     * @brief Run f and count the misses it causes.
+     */
+    template <typename F>
+    void measure(F&& f, std::uint64_t& l1d_misses, std::uint64_t& llc_misses) {
+        l1d_misses = llc_misses = 0;
+        if (!valid()) {
+            f();
+            return;
+        }
+#ifdef __linux__
+        for (int fd : {l1d_fd, llc_fd}) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        f();
+        for (int fd : {l1d_fd, llc_fd})
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(l1d_fd, &l1d_misses, sizeof(l1d_misses)) != sizeof(l1d_misses))
+            l1d_misses = 0;
+        if (read(llc_fd, &llc_misses, sizeof(llc_misses)) != sizeof(llc_misses))
+            llc_misses = 0;
+#endif
+    }
+
+private:
+    int l1d_fd = -1;
+    int llc_fd = -1;
+
+#ifdef __linux__
+    static int open(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+};
+
+#endif // CACHE_COUNTERS_H
@@ -0,0 +1,51 @@
+/**
+ * @file counting_metric.hpp
+ * @author Siddarth Sheth
+ * @brief Metric wrapper that counts distance evaluations, for benchmarks.
+ */
+
+#ifndef COUNTING_METRIC_H
+#define COUNTING_METRIC_H
+
+#include <cstdint>
+
+/**
+ * @brief Wraps a metric and counts the distance evaluations made through it.
+ */
+template <typename Metric>
+struct CountingMetric {
+    Metric metric;
+    std::uint64_t* evals;
+
+    explicit CountingMetric(std::uint64_t* evals, Metric metric = Metric()): metric(metric), evals(evals) {}
+
+    template <typename P>
+    double compare_dist(const P& a, const P& b) const {
+        ++*evals;
+        return metric.compare_dist(a, b);
+    }
+
+    template <typename P>
+    double dist(const P& a, const P& b) const {
+        ++*evals;
+        return metric.dist(a, b);
+    }
+
+    template <typename P>
+    double compare_dist_bounded(const P& a, const P& b, double limit) const {
+        ++*evals;
+        return metric.compare_dist_bounded(a, b, limit);
+    }
+
+    template <typename P>
+    double dist_bounded(const P& a, const P& b, double limit) const {
+        ++*evals;
+        return metric.dist_bounded(a, b, limit);
+    }
+
+    double to_compare_dist(double r) const {
+        return metric.to_compare_dist(r);
+    }
+};
+
+#endif // COUNTING_METRIC_H
@@ -0,0 +1,135 @@
+/**
+ * @file datasets.hpp
+ * @author Siddarth Sheth
+ * @brief Deterministic synthetic datasets for benchmarks.
+ *
+ * Every generator is seeded explicitly, so a (distribution, n, seed) triple
+ * always yields the same points across runs and machines with the same
+ * standard library.
+ */
+
+#ifndef DATASETS_H
+#define DATASETS_H
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "point.hpp"
+
+/**
+ * @brief Shape of a synthetic dataset.
+ */
+enum class Distribution {
+    uniform,    // uniform in the unit cube
+    clustered,  // Gaussian blobs around uniformly placed centers
+    low_dim     // uniform on a random 2-dimensional affine subspace, plus small noise
+};
+
+inline const char* distribution_name(Distribution dist) {
+    switch (dist) {
+        case Distribution::uniform: return "uniform";
+        case Distribution::clustered: return "clustered";
+        case Distribution::low_dim: return "low_dim";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief n points of dimension d drawn from dist.
+ */
+template <std::size_t d>
+std::vector<std::array<double, d>> make_points(Distribution dist, std::size_t n, unsigned seed) {
+    using Pt = std::array<double, d>;
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> unif(0, 1);
+    std::normal_distribution<double> gauss(0, 1);
+    std::vector<Pt> pts(n);
+
+    switch (dist) {
+    case Distribution::uniform:
+        for (auto& p : pts)
+            for (auto& x : p)
+                x = unif(gen);
+        break;
+
+    case Distribution::clustered: {
+        const std::size_t num_clusters = 32;
+        const double spread = 0.02;
+        std::vector<Pt> centers(num_clusters);
+        for (auto& c : centers)
+            for (auto& x : c)
+                x = unif(gen);
+        std::uniform_int_distribution<std::size_t> pick(0, num_clusters - 1);
+        for (auto& p : pts) {
+            const Pt& c = centers[pick(gen)];
+            for (std::size_t i = 0; i < d; i++)
+                p[i] = c[i] + spread * gauss(gen);
+        }
+        break;
+    }
+
+    case Distribution::low_dim: {
+        const std::size_t k = 2;
+        const double noise = 1e-3;
+        std::array<Pt, k> basis;
+        Pt offset;
+        for (auto& b : basis)
+            for (auto& x : b)
+                x = gauss(gen) / std::sqrt(double(d));
+        for (auto& x : offset)
+            x = unif(gen);
+        for (auto& p : pts) {
+            p = offset;
+            for (std::size_t j = 0; j < k; j++) {
+                double t = unif(gen);
+                for (std::size_t i = 0; i < d; i++)
+                    p[i] += t * basis[j][i];
+            }
+            for (auto& x : p)
+                x += noise * gauss(gen);
+        }
+        break;
+    }
+    }
+    return pts;
+}
+
+/**
+ * @brief n binary codes of the given length, the sign bits of random projections
+ * of 16-dimensional points drawn from dist.
+ */
+template <std::size_t bits>
+std::vector<BitPoint<bits>> make_codes(Distribution dist, std::size_t n, unsigned seed) {
+    constexpr std::size_t k = 16;
+    auto pts = make_points<k>(dist, n, seed);
+    std::mt19937_64 gen(seed ^ 0x9e3779b97f4a7c15ULL);
+    std::normal_distribution<double> gauss(0, 1);
+    std::vector<std::array<double, k>> planes(bits);
+    for (auto& h : planes)
+        for (auto& x : h)
+            x = gauss(gen);
+
+    // center the points so that the hyperplanes through the origin split them
+    std::array<double, k> mean{};
+    for (auto& p : pts)
+        for (std::size_t i = 0; i < k; i++)
+            mean[i] += p[i] / n;
+
+    std::vector<BitPoint<bits>> codes(n);
+    for (std::size_t j = 0; j < n; j++) {
+        codes[j].fill(0);
+        for (std::size_t b = 0; b < bits; b++) {
+            double dot = 0;
+            for (std::size_t i = 0; i < k; i++)
+                dot += planes[b][i] * (pts[j][i] - mean[i]);
+            if (dot > 0)
+                codes[j][b / 64] |= std::uint64_t(1) << (b % 64);
+        }
+    }
+    return codes;
+}
+
+#endif // DATASETS_H
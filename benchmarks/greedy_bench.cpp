@@ -0,0 +1,384 @@
+/**
+ * @file greedy_bench.cpp
+ * @author Siddarth Sheth
+ * @brief Benchmarks for construction and search.
+ *
+ * Each benchmark is parameterized by dimension and metric at compile time and
+ * by n, data distribution and, for searches, eps at run time. Besides time,
+ * every benchmark reports the number of distance evaluations per operation
+ * ("evals"), measured in one extra untimed run with a counting metric.
+ *
+ * Run a subset with, e.g., --benchmark_filter='Clarkson<8, L2Metric>'.
+ *
+ * NNSinglePacked runs the queries of NNSingle over the PackedGT layout. The
+ * Layout benchmarks compare the two on trees larger than the caches. Both
+ * report L1 data cache read misses ("L1D-miss") and last-level cache misses
+ * ("LLC-miss") per query, counted with perf_event_open in one more pass over
+ * the queries; the counters are left out where the PMU is not available. Run
+ * them with --benchmark_filter=Layout/.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <algorithm>
+
+#include "balltree.hpp"
+#include "fast_search_impl.hpp"
+#include "packed_gt.hpp"
+#include "datasets.hpp"
+#include "counting_metric.hpp"
+#include "cache_counters.hpp"
+
+// Seeds of the indexed points and of the queries.
+constexpr unsigned data_seed = 1;
+constexpr unsigned query_seed = 2;
+constexpr std::size_t num_queries = 1000;
+
+// Expected number of points within the radius of a range query.
+constexpr std::size_t range_k = 16;
+
+template <typename Metric>
+struct PointsFor { template <std::size_t d> using type = std::array<double, d>; };
+
+template <>
+struct PointsFor<HammingMetric> { template <std::size_t bits> using type = BitPoint<bits>; };
+
+/**
+ * @brief Point type used with a given dimension and metric: d coordinates, or d bits for HammingMetric.
+ */
+template <std::size_t d, typename Metric>
+using BenchPt = typename PointsFor<Metric>::template type<d>;
+
+template <std::size_t d, typename Metric>
+std::vector<BenchPt<d, Metric>> dataset(Distribution dist, std::size_t n, unsigned seed) {
+    if constexpr (std::is_same_v<Metric, HammingMetric>)
+        return make_codes<d>(dist, n, seed);
+    else
+        return make_points<d>(dist, n, seed);
+}
+
+/**
+ * @brief An indexed dataset and a query set, both in fast_gt layout, with a range query radius.
+ */
+template <std::size_t d, typename Metric>
+struct SearchFixture {
+    using PtT = BenchPt<d, Metric>;
+    static constexpr std::size_t D = point_dim<PtT>::value;
+
+    GTPoints<D, PtT> G, Q;
+    GTData aux, aux_q;
+    double radius;
+
+    SearchFixture(Distribution dist, std::size_t n) {
+        Metric metric;
+        auto pts = dataset<d, Metric>(dist, n, data_seed);
+        auto queries = dataset<d, Metric>(dist, num_queries, query_seed);
+        radius = range_radius(pts, queries, metric);
+        fast_gt(greedy_tree(pts, metric).get(), G, aux);
+        fast_gt(greedy_tree(queries, metric).get(), Q, aux_q);
+    }
+
+    /**
+     * @brief Median over a sample of queries of the distance to the range_k-th nearest point.
+     */
+    static double range_radius(const std::vector<PtT>& pts, const std::vector<PtT>& queries, Metric metric) {
+        std::vector<double> kth;
+        for (std::size_t i = 0; i < std::min<std::size_t>(queries.size(), 50); i++) {
+            std::vector<double> dists;
+            for (auto& p : pts)
+                dists.push_back(metric.dist(p, queries[i]));
+            std::size_t k = std::min(range_k, dists.size()) - 1;
+            std::nth_element(dists.begin(), dists.begin() + k, dists.end());
+            kth.push_back(dists[k]);
+        }
+        std::nth_element(kth.begin(), kth.begin() + kth.size() / 2, kth.end());
+        return kth[kth.size() / 2];
+    }
+
+    /**
+     * @brief The fixture for (dist, n), built on first use and kept for later benchmarks.
+     */
+    static SearchFixture& get(Distribution dist, std::size_t n) {
+        static std::map<std::pair<Distribution, std::size_t>, std::unique_ptr<SearchFixture>> cache;
+        auto& f = cache[{dist, n}];
+        if (!f)
+            f = std::make_unique<SearchFixture>(dist, n);
+        return *f;
+    }
+};
+
+static Distribution distribution_arg(const benchmark::State& state) {
+    return static_cast<Distribution>(state.range(1));
+}
+
+static double eps_arg(const benchmark::State& state) {
+    return state.range(2) / 100.0;
+}
+
+static void set_counters(benchmark::State& state, std::uint64_t evals, std::size_t ops_per_iter) {
+    state.SetLabel(distribution_name(distribution_arg(state)));
+    state.SetItemsProcessed(state.iterations() * ops_per_iter);
+    state.counters["evals"] = double(evals) / ops_per_iter;
+}
+
+template <std::size_t d, typename Metric>
+static void Clarkson(benchmark::State& state) {
+    auto pts = dataset<d, Metric>(distribution_arg(state), state.range(0), data_seed);
+    std::vector<std::size_t> pred;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto work = pts;
+        state.ResumeTiming();
+        clarkson(work, pred, Metric());
+        benchmark::DoNotOptimize(pred.data());
+    }
+    std::uint64_t evals = 0;
+    clarkson(pts, pred, CountingMetric<Metric>(&evals));
+    set_counters(state, evals, 1);
+}
+
+template <std::size_t d, typename Metric>
+static void Gonzalez(benchmark::State& state) {
+    auto pts = dataset<d, Metric>(distribution_arg(state), state.range(0), data_seed);
+    std::vector<std::size_t> pred;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto work = pts;
+        state.ResumeTiming();
+        gonzalez(work, pred, Metric());
+        benchmark::DoNotOptimize(pred.data());
+    }
+    std::uint64_t evals = 0;
+    gonzalez(pts, pred, CountingMetric<Metric>(&evals));
+    set_counters(state, evals, 1);
+}
+
+template <std::size_t d, typename Metric>
+static void GreedyTree(benchmark::State& state) {
+    auto pts = dataset<d, Metric>(distribution_arg(state), state.range(0), data_seed);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto work = pts;
+        state.ResumeTiming();
+        auto root = construct_tree(work, Metric());
+        compute_radii(root.get());
+        benchmark::DoNotOptimize(root.get());
+        state.PauseTiming();
+        root.reset();
+        state.ResumeTiming();
+    }
+    std::uint64_t evals = 0;
+    greedy_tree(pts, CountingMetric<Metric>(&evals));
+    set_counters(state, evals, 1);
+}
+
+template <std::size_t d, typename Metric>
+static void FastGT(benchmark::State& state) {
+    using PtT = BenchPt<d, Metric>;
+    constexpr std::size_t D = point_dim<PtT>::value;
+    auto pts = dataset<d, Metric>(distribution_arg(state), state.range(0), data_seed);
+    auto root = greedy_tree(pts, Metric());
+    for (auto _ : state) {
+        GTPoints<D, PtT> G;
+        GTData aux;
+        fast_gt(root.get(), G, aux);
+        benchmark::DoNotOptimize(G.data());
+    }
+    set_counters(state, 0, 1);
+}
+
+/**
+ * @brief Report the cache misses per query of one more pass of search over the queries.
+ */
+template <typename Search, typename Queries>
+static void set_cache_counters(benchmark::State& state, Search& search, const Queries& Q, double e) {
+    CacheCounters counters;
+    if (!counters.valid())
+        return;
+    std::uint64_t l1d_misses, llc_misses;
+    counters.measure([&] {
+        for (auto& [q, q_aux] : Q)
+            benchmark::DoNotOptimize(search(q, e));
+    }, l1d_misses, llc_misses);
+    state.counters["L1D-miss"] = double(l1d_misses) / Q.size();
+    state.counters["LLC-miss"] = double(llc_misses) / Q.size();
+}
+
+template <std::size_t d, typename Metric>
+static void NNSingle(benchmark::State& state) {
+    using PtT = BenchPt<d, Metric>;
+    constexpr std::size_t D = SearchFixture<d, Metric>::D;
+    auto& f = SearchFixture<d, Metric>::get(distribution_arg(state), state.range(0));
+    double e = eps_arg(state);
+    Metric metric;
+    ApxNNSearch<D, Metric, PtT> search(f.G, f.aux, metric);
+    for (auto _ : state)
+        for (auto& [q, q_aux] : f.Q)
+            benchmark::DoNotOptimize(search(q, e));
+    set_cache_counters(state, search, f.Q, e);
+
+    std::uint64_t evals = 0;
+    CountingMetric<Metric> counting(&evals);
+    ApxNNSearch<D, CountingMetric<Metric>, PtT> counted(f.G, f.aux, counting);
+    for (auto& [q, q_aux] : f.Q)
+        counted(q, e);
+    set_counters(state, evals, f.Q.size());
+}
+
+template <std::size_t d, typename Metric>
+static void NNSinglePacked(benchmark::State& state) {
+    using PtT = BenchPt<d, Metric>;
+    constexpr std::size_t D = SearchFixture<d, Metric>::D;
+    auto& f = SearchFixture<d, Metric>::get(distribution_arg(state), state.range(0));
+    double e = eps_arg(state);
+    Metric metric;
+    PackedGT<PtT> packed;
+    pack_gt(f.G, f.aux, packed);
+    PackedNNSearch<D, Metric, PtT> search(packed, metric);
+    for (auto _ : state)
+        for (auto& [q, q_aux] : f.Q)
+            benchmark::DoNotOptimize(search(q, e));
+    set_cache_counters(state, search, f.Q, e);
+
+    std::uint64_t evals = 0;
+    CountingMetric<Metric> counting(&evals);
+    PackedNNSearch<D, CountingMetric<Metric>, PtT> counted(packed, counting);
+    for (auto& [q, q_aux] : f.Q)
+        counted(q, e);
+    set_counters(state, evals, f.Q.size());
+}
+
+template <std::size_t d, typename Metric>
+static void NNBatch(benchmark::State& state) {
+    using PtT = BenchPt<d, Metric>;
+    constexpr std::size_t D = SearchFixture<d, Metric>::D;
+    auto& f = SearchFixture<d, Metric>::get(distribution_arg(state), state.range(0));
+    double e = eps_arg(state);
+    Metric metric;
+    ApxNNSearch<D, Metric, PtT> search(f.G, f.aux, metric);
+    std::vector<std::size_t> nns;
+    for (auto _ : state) {
+        search(f.Q, f.aux_q, nns, e);
+        benchmark::DoNotOptimize(nns.data());
+    }
+
+    std::uint64_t evals = 0;
+    CountingMetric<Metric> counting(&evals);
+    ApxNNSearch<D, CountingMetric<Metric>, PtT> counted(f.G, f.aux, counting);
+    counted(f.Q, f.aux_q, nns, e);
+    set_counters(state, evals, f.Q.size());
+}
+
+template <std::size_t d, typename Metric>
+static void RangeSingle(benchmark::State& state) {
+    using PtT = BenchPt<d, Metric>;
+    constexpr std::size_t D = SearchFixture<d, Metric>::D;
+    auto& f = SearchFixture<d, Metric>::get(distribution_arg(state), state.range(0));
+    double e = eps_arg(state);
+    Metric metric;
+    ApxRngSearch<D, Metric, PtT> search(f.G, f.aux, metric);
+    SearchRangeVec ranges;
+    for (auto _ : state)
+        for (auto& [q, q_aux] : f.Q) {
+            search(q, f.radius, ranges, e);
+            benchmark::DoNotOptimize(ranges.data());
+        }
+
+    std::uint64_t evals = 0;
+    CountingMetric<Metric> counting(&evals);
+    ApxRngSearch<D, CountingMetric<Metric>, PtT> counted(f.G, f.aux, counting);
+    for (auto& [q, q_aux] : f.Q)
+        counted(q, f.radius, ranges, e);
+    set_counters(state, evals, f.Q.size());
+}
+
+template <std::size_t d, typename Metric>
+static void RangeBatch(benchmark::State& state) {
+    using PtT = BenchPt<d, Metric>;
+    constexpr std::size_t D = SearchFixture<d, Metric>::D;
+    auto& f = SearchFixture<d, Metric>::get(distribution_arg(state), state.range(0));
+    double e = eps_arg(state);
+    Metric metric;
+    ApxRngSearch<D, Metric, PtT> search(f.G, f.aux, metric);
+    std::vector<SearchRangeVec> ranges;
+    for (auto _ : state) {
+        search(f.Q, f.aux_q, f.radius, ranges, e);
+        benchmark::DoNotOptimize(ranges.data());
+    }
+
+    std::uint64_t evals = 0;
+    CountingMetric<Metric> counting(&evals);
+    ApxRngSearch<D, CountingMetric<Metric>, PtT> counted(f.G, f.aux, counting);
+    counted(f.Q, f.aux_q, f.radius, ranges, e);
+    set_counters(state, evals, f.Q.size());
+}
+
+static const std::vector<std::int64_t> distributions = {
+    static_cast<std::int64_t>(Distribution::uniform),
+    static_cast<std::int64_t>(Distribution::clustered),
+    static_cast<std::int64_t>(Distribution::low_dim)};
+
+// n and distribution; max_n is kept small where a build is slow, e.g. uniform data in high dimension
+template <std::int64_t max_n>
+static void build_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"n", "dist"})
+     ->ArgsProduct({{max_n / 8, max_n}, distributions})
+     ->Unit(benchmark::kMillisecond);
+}
+
+// Gonzalez is quadratic, so it only runs on the smaller size.
+template <std::int64_t max_n>
+static void quadratic_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"n", "dist"})
+     ->ArgsProduct({{max_n / 8}, distributions})
+     ->Unit(benchmark::kMillisecond);
+}
+
+// n, distribution and eps in hundredths
+template <std::int64_t max_n>
+static void search_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"n", "dist", "eps%"})
+     ->ArgsProduct({{max_n / 8, max_n}, distributions, {0, 50, 100}})
+     ->Unit(benchmark::kMicrosecond);
+}
+
+// n beyond the caches, distribution and eps, for the layout comparison
+template <std::int64_t n>
+static void layout_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"n", "dist", "eps%"})
+     ->ArgsProduct({{n}, {static_cast<std::int64_t>(Distribution::uniform),
+                          static_cast<std::int64_t>(Distribution::clustered)}, {0}})
+     ->Unit(benchmark::kMicrosecond);
+}
+
+#define GREEDY_BENCHMARKS(d, Metric, max_n)                                    \
+    BENCHMARK_TEMPLATE(Clarkson, d, Metric)->Apply(build_args<max_n>);          \
+    BENCHMARK_TEMPLATE(Gonzalez, d, Metric)->Apply(quadratic_args<max_n>);      \
+    BENCHMARK_TEMPLATE(GreedyTree, d, Metric)->Apply(build_args<max_n>);        \
+    BENCHMARK_TEMPLATE(FastGT, d, Metric)->Apply(build_args<max_n>);            \
+    BENCHMARK_TEMPLATE(NNSingle, d, Metric)->Apply(search_args<max_n>);         \
+    BENCHMARK_TEMPLATE(NNSinglePacked, d, Metric)->Apply(search_args<max_n>);   \
+    BENCHMARK_TEMPLATE(NNBatch, d, Metric)->Apply(search_args<max_n>);          \
+    BENCHMARK_TEMPLATE(RangeSingle, d, Metric)->Apply(search_args<max_n>);      \
+    BENCHMARK_TEMPLATE(RangeBatch, d, Metric)->Apply(search_args<max_n>)
+
+GREEDY_BENCHMARKS(2, L2Metric, 1 << 15);
+GREEDY_BENCHMARKS(8, L2Metric, 1 << 15);
+GREEDY_BENCHMARKS(32, L2Metric, 1 << 13);
+GREEDY_BENCHMARKS(8, L1Metric, 1 << 15);
+GREEDY_BENCHMARKS(64, HammingMetric, 1 << 14);
+
+#define LAYOUT_BENCHMARKS(d, Metric, n)                                        \
+    BENCHMARK_TEMPLATE(NNSingle, d, Metric)->Name("Layout/NNSingle<" #d ", " #Metric ">")             \
+        ->Apply(layout_args<n>);                                                                      \
+    BENCHMARK_TEMPLATE(NNSinglePacked, d, Metric)->Name("Layout/NNSinglePacked<" #d ", " #Metric ">") \
+        ->Apply(layout_args<n>)
+
+LAYOUT_BENCHMARKS(2, L2Metric, 1 << 20);
+LAYOUT_BENCHMARKS(8, L2Metric, 1 << 17);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,169 @@
+/**
+ * @file adjacency.hpp
+ * @author Siddarth Sheth
+ * @brief Compact adjacency lists stored in chunks of a shared pool.
+ *
+ * Every list lives in a contiguous chunk of a single pool of ids. Chunk sizes
+ * are powers of two; a list that outgrows its chunk moves to a chunk of the
+ * next size and the old chunk is recycled through a free list. Once the pool
+ * and free lists have grown to the working size, adding and removing edges
+ * performs no heap allocation.
+ */
+
+#ifndef ADJACENCY_H
+#define ADJACENCY_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+
+/**
+ * @brief Adjacency lists of a graph whose vertices are numbered 0, 1, ...
+ *
+ * @tparam Id Integer type of the stored vertex ids.
+ */
+template <typename Id = std::uint32_t>
+class ChunkedAdjacency {
+public:
+    /**
+     * @brief Read-only view of one adjacency list.
+     */
+    struct Range {
+        const Id* first;
+        const Id* last;
+        const Id* begin() const { return first; }
+        const Id* end() const { return last; }
+        std::size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+    /**
+     * @brief Reserve room for n vertices.
+     */
+    void reserve(std::size_t n) { lists.reserve(n); }
+
+    /**
+     * @brief Append a vertex with an empty list and return its index.
+     */
+    std::size_t add_vertex() {
+        lists.push_back(List());
+        return lists.size() - 1;
+    }
+
+    std::size_t num_vertices() const { return lists.size(); }
+
+    /**
+     * @brief Number of ids in the list of vertex i.
+     */
+    std::size_t degree(std::size_t i) const { return lists[i].size; }
+
+    Range operator[](std::size_t i) const {
+        const Id* first = pool.data() + lists[i].offset;
+        return Range{first, first + lists[i].size};
+    }
+
+    /**
+     * @brief Append j to the list of vertex i.
+     */
+    void push_back(std::size_t i, std::size_t j) {
+        assert(j <= max_id);
+        if (lists[i].size == chunk_size(lists[i].cls))
+            grow(i, lists[i].size + 1);
+        pool[lists[i].offset + lists[i].size++] = static_cast<Id>(j);
+    }
+
+    /**
+     * @brief Make room for n more ids in the list of vertex i.
+     */
+    void reserve(std::size_t i, std::size_t n) {
+        std::size_t needed = lists[i].size + n;
+        if (needed > chunk_size(lists[i].cls))
+            grow(i, needed);
+    }
+
+    /**
+     * @brief Remove the ids j of vertex i for which pred(j) holds, keeping the order of the rest.
+     */
+    template <typename Pred>
+    void remove_if(std::size_t i, Pred pred) {
+        Id* first = pool.data() + lists[i].offset;
+        Id* last = std::remove_if(first, first + lists[i].size,
+                                  [&](Id j) { return pred(static_cast<std::size_t>(j)); });
+        lists[i].size = static_cast<Id>(last - first);
+    }
+
+    /**
+     * @brief Empty the list of vertex i and return its chunk to the pool.
+     */
+    void clear(std::size_t i) {
+        List& l = lists[i];
+        if (l.cls != no_chunk)
+            release_chunk(l.offset, l.cls);
+        l = List();
+    }
+
+    /**
+     * @brief Bytes allocated by the pool, the list headers and the free lists.
+     */
+    std::size_t capacity_bytes() const {
+        std::size_t bytes = pool.capacity() * sizeof(Id) + lists.capacity() * sizeof(List);
+        for (auto& f : free_chunks)
+            bytes += f.capacity() * sizeof(std::size_t);
+        return bytes;
+    }
+
+    static constexpr std::size_t max_id = static_cast<Id>(-1) - 1;
+
+private:
+    static constexpr std::uint8_t no_chunk = 0xff;
+    static constexpr std::size_t min_chunk = 4;
+
+    struct List {
+        std::size_t offset = 0;
+        Id size = 0;
+        std::uint8_t cls = no_chunk;
+    };
+
+    std::vector<Id> pool;
+    std::vector<List> lists;
+    // free_chunks[c] holds the offsets of released chunks of size min_chunk << c
+    std::vector<std::vector<std::size_t>> free_chunks;
+
+    static std::size_t chunk_size(std::uint8_t cls) {
+        return cls == no_chunk ? 0 : min_chunk << cls;
+    }
+
+    std::size_t take_chunk(std::uint8_t cls) {
+        if (cls < free_chunks.size() && !free_chunks[cls].empty()) {
+            std::size_t offset = free_chunks[cls].back();
+            free_chunks[cls].pop_back();
+            return offset;
+        }
+        std::size_t offset = pool.size();
+        pool.resize(offset + chunk_size(cls));
+        return offset;
+    }
+
+    void release_chunk(std::size_t offset, std::uint8_t cls) {
+        if (cls >= free_chunks.size())
+            free_chunks.resize(cls + 1);
+        free_chunks[cls].push_back(offset);
+    }
+
+    void grow(std::size_t i, std::size_t needed) {
+        std::uint8_t cls = 0;
+        while (chunk_size(cls) < needed)
+            cls++;
+        std::size_t offset = take_chunk(cls);
+        List& l = lists[i];
+        std::copy(pool.begin() + l.offset, pool.begin() + l.offset + l.size, pool.begin() + offset);
+        if (l.cls != no_chunk)
+            release_chunk(l.offset, l.cls);
+        l.offset = offset;
+        l.cls = cls;
+    }
+};
+
+#endif // ADJACENCY_H
@@ -11,6 +11,8 @@
 #define BALLTREE_H
 
 #include "greedy.hpp"
+#include "budget.hpp"
+#include <queue>
 #include <stack>
 #include <unordered_map>
 #include <deque>
@@ -22,11 +24,12 @@
  *
  * @tparam d Dimensionality of the space.
  * @tparam Metric Metric type for distance calculations.
+ * @tparam PtT Point type, e.g. a BitPoint for the HammingMetric.
  *
  * Each BallTree node represents a ball (center and radius) containing a subset of points.
  * Nodes may have left/right children for recursive partitioning.
  */
-template<size_t d, typename Metric>
+template<size_t d, typename Metric, typename PtT = std::array<double, d>>
 class BallTree {
 public:
     /**
@@ -44,7 +47,7 @@ public:
         }
     };
 
-    using Pt = std::array<double, d>;
+    using Pt = PtT;
     /**
      * @brief Pointer to a Point in d-dimensional space.
      */
@@ -52,14 +55,14 @@ public:
     /**
      * @brief Unique pointer to a BallTree node.
      */
-    using BallTreeUPtr = std::unique_ptr<BallTree<d, Metric>>;
-    using BallTreePtr = BallTree<d, Metric>*;
+    using BallTreeUPtr = std::unique_ptr<BallTree<d, Metric, PtT>>;
+    using BallTreePtr = BallTree<d, Metric, PtT>*;
     /**
      * @brief Max-heap of BallTree pointers, ordered by radius.
      */
     using BallHeap = std::priority_queue<
-                                BallTree<d, Metric>*,
-                                std::vector<BallTree<d, Metric>*>,
+                                BallTree<d, Metric, PtT>*,
+                                std::vector<BallTree<d, Metric, PtT>*>,
                                 BallTreeCompare
                             >;
     
@@ -111,6 +114,14 @@ public:
     vector<PtPtr> points();
 
     PtPtr nearest(PtPtr query);
+    /**
+     * @brief Nearest neighbor search that stops early when the budget runs out.
+     *
+     * Balls are expanded in order of the smallest distance any of their points
+     * could have from the query, and the answer carries the smallest such
+     * distance among the balls left unexpanded.
+     */
+    AnytimeNN<PtPtr> nearest(PtPtr query, const SearchBudget& budget);
     PtPtr farthest(PtPtr query);
     vector<BallTree*> range(PtPtr query, double q_radius);
     
@@ -131,8 +142,8 @@ public:
 /**
  * @brief Type alias for unique pointer to BallTree node.
  */
-template<size_t d, typename Metric>
-using BallTreeUPtr = std::unique_ptr<BallTree<d, Metric>>;
+template<size_t d, typename Metric, typename PtT = std::array<double, d>>
+using BallTreeUPtr = std::unique_ptr<BallTree<d, Metric, PtT>>;
 
 /**
  * @brief Type alias for vector of constant Point pointers.
@@ -143,15 +154,26 @@ using PtVec = std::vector<std::array<double, d>>;
 /**
  * @brief Type alias for max-heap of BallTree pointers, ordered by radius.
  */
-template<size_t d, typename Metric>
+template<size_t d, typename Metric, typename PtT = std::array<double, d>>
 using BallHeap = std::priority_queue<
-                                    BallTree<d, Metric>*,
-                                    vector<BallTree<d, Metric>*>,
-                                    typename BallTree<d, Metric>::BallTreeCompare
+                                    BallTree<d, Metric, PtT>*,
+                                    vector<BallTree<d, Metric, PtT>*>,
+                                    typename BallTree<d, Metric, PtT>::BallTreeCompare
                                 >;
 
-template<size_t d, typename Metric>
-BallTreeUPtr<d, Metric> greedy_tree(PtVec<d>& pts, Metric metric);
+/**
+ * @brief Build a greedy tree with 2-approximate radii.
+ *
+ * @tparam Idx Integer type of the predecessor array used during the build.
+ */
+template<typename Idx = std::size_t, typename PtT, typename Metric>
+BallTreeUPtr<point_dim<PtT>::value, Metric, PtT> greedy_tree(std::vector<PtT>& pts, Metric metric);
+
+/**
+ * @brief Add the bytes held by the nodes of the tree to report (the points are not owned by the tree).
+ */
+template<size_t d, typename Metric, typename PtT>
+void memory_usage(const BallTree<d, Metric, PtT>* root, MemoryReport& report);
 
 #include<balltree_impl.hpp>
 
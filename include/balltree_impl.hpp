@@ -1,32 +1,32 @@
-template<size_t d, typename Metric>
-BallTree<d, Metric>::BallTree(PtPtr& p, Metric metric)
+template<size_t d, typename Metric, typename PtT>
+BallTree<d, Metric, PtT>::BallTree(PtPtr& p, Metric metric)
     : center(p), radius(0), size(1), left(nullptr), right(nullptr), metric(metric) {}
 
-template<size_t d, typename Metric>
-bool BallTree<d, Metric>::isleaf(){
+template<size_t d, typename Metric, typename PtT>
+bool BallTree<d, Metric, PtT>::isleaf(){
     return left == nullptr;
 }
 
-template<size_t d, typename Metric>
-double BallTree<d, Metric>::dist(PtPtr p){
+template<size_t d, typename Metric, typename PtT>
+double BallTree<d, Metric, PtT>::dist(PtPtr p){
     return metric.dist(*center, *p);
 }
 
-template<size_t d, typename Metric>
-BallHeap<d, Metric> BallTree<d, Metric>::heap(){
+template<size_t d, typename Metric, typename PtT>
+BallHeap<d, Metric, PtT> BallTree<d, Metric, PtT>::heap(){
     BallHeap ball_heap;
 
     ball_heap.push(this);
     return ball_heap;
 }
 
-template<size_t d, typename Metric>
-void BallTree<d, Metric>::get_traversal(vector<HeapOrderEntry>& output){
+template<size_t d, typename Metric, typename PtT>
+void BallTree<d, Metric, PtT>::get_traversal(vector<HeapOrderEntry>& output){
     output.clear();
     output.reserve(size);
     output.push_back({*center, radius, 0, 0.0});
     
-    std::unordered_map<std::array<double, d>, size_t> index;
+    std::unordered_map<Pt, size_t, PointHash> index;
     index[*center] = 0;
     
     auto to_traverse = heap();
@@ -48,8 +48,8 @@ void BallTree<d, Metric>::get_traversal(vector<HeapOrderEntry>& output){
     }
 }
 
-template<size_t d, typename Metric>
-void BallTree<d, Metric>::get_traversal(vector<BallTreePtr>& output){
+template<size_t d, typename Metric, typename PtT>
+void BallTree<d, Metric, PtT>::get_traversal(vector<BallTreePtr>& output){
     output.clear();
 
     auto to_traverse = heap();
@@ -64,27 +64,18 @@ void BallTree<d, Metric>::get_traversal(vector<BallTreePtr>& output){
     }
 }
 
-template<size_t d, typename Metric>
-BallTreeUPtr<d, Metric> greedy_tree(PtVec<d>& pts, Metric metric){
-    // Construct the tree topology
-    auto root = construct_tree(pts, metric);
-    // Compute radii for each node
-    compute_radii(root.get());
-
-    return std::move(root);
-}
-
-template<size_t d, typename Metric>
-BallTreeUPtr<d, Metric> construct_tree(PtVec<d>& pts, Metric metric)
+template<typename Idx = std::size_t, typename PtT, typename Metric>
+BallTreeUPtr<point_dim<PtT>::value, Metric, PtT> construct_tree(std::vector<PtT>& pts, Metric metric)
 {
-    using PtPtr = const std::array<double, d>*;
-    using BallTreePtr = BallTree<d, Metric>*;
+    constexpr size_t d = point_dim<PtT>::value;
+    using PtPtr = const PtT*;
+    using BallTreePtr = BallTree<d, Metric, PtT>*;
     
-    vector<size_t> pred;
+    vector<Idx> pred;
     clarkson(pts, pred, metric);
     
     PtPtr root_pt = &pts[0];
-    auto root = std::make_unique<BallTree<d, Metric>>(root_pt, metric);
+    auto root = std::make_unique<BallTree<d, Metric, PtT>>(root_pt, metric);
     
     // unordered_map<size_t, BallTreePtr> leaf;
     vector<BallTreePtr> leaf(pts.size(), nullptr);
@@ -94,8 +85,8 @@ BallTreeUPtr<d, Metric> construct_tree(PtVec<d>& pts, Metric metric)
         auto node = leaf[pred[i]];
         PtPtr right_pt = &pts[i];
         
-        node->left = std::make_unique<BallTree<d, Metric>>(node->center, metric);
-        node->right = std::make_unique<BallTree<d, Metric>>(right_pt, metric);
+        node->left = std::make_unique<BallTree<d, Metric, PtT>>(node->center, metric);
+        node->right = std::make_unique<BallTree<d, Metric, PtT>>(right_pt, metric);
         
         leaf[pred[i]] = (node->left).get();
         leaf[i] = (node->right).get();
@@ -106,9 +97,9 @@ BallTreeUPtr<d, Metric> construct_tree(PtVec<d>& pts, Metric metric)
 
 // This method computes 2-approximate radii in linear time.
 // Computing exact radius requires finding the point farthest from the center for each node.
-template <size_t d, typename Metric>
-void compute_radii(BallTree<d, Metric>* root) {
-    using BallTreePtr = BallTree<d, Metric>*;
+template<size_t d, typename Metric, typename PtT>
+void compute_radii(BallTree<d, Metric, PtT>* root) {
+    using BallTreePtr = BallTree<d, Metric, PtT>*;
 
     std::stack<std::pair<BallTreePtr, bool>> stk;
     stk.push({root, false});
@@ -137,16 +128,26 @@ void compute_radii(BallTree<d, Metric>* root) {
     }
 }
 
-template <size_t d, typename Metric>
-const std::array<double, d>* BallTree<d, Metric>::nearest(PtPtr query){
+template<typename Idx, typename PtT, typename Metric>
+BallTreeUPtr<point_dim<PtT>::value, Metric, PtT> greedy_tree(std::vector<PtT>& pts, Metric metric){
+    // Construct the tree topology
+    auto root = construct_tree<Idx>(pts, metric);
+    // Compute radii for each node
+    compute_radii(root.get());
+
+    return std::move(root);
+}
+
+template<size_t d, typename Metric, typename PtT>
+const PtT* BallTree<d, Metric, PtT>::nearest(PtPtr query){
     PtPtr nearest = nullptr;
     double nn_dist = std::numeric_limits<double>::max();
     
-    auto is_viable = [&](BallTree<d, Metric>* node){
+    auto is_viable = [&](BallTreePtr node){
         return node->dist(query) - node->radius < nn_dist;
     };
 
-    auto update = [&](BallTree<d, Metric>* top){
+    auto update = [&](BallTreePtr top){
         double top_dist = top->dist(query);
         if(top_dist < nn_dist){
             nearest = top->center;
@@ -158,8 +159,49 @@ const std::array<double, d>* BallTree<d, Metric>::nearest(PtPtr query){
     return nearest;
 }
 
-template <size_t d, typename Metric>
-const std::array<double, d>* BallTree<d, Metric>::farthest(PtPtr query){
+template<size_t d, typename Metric, typename PtT>
+AnytimeNN<const PtT*> BallTree<d, Metric, PtT>::nearest(PtPtr query, const SearchBudget& budget){
+    using Entry = std::tuple<double, double, BallTreePtr>;    // lower bound, distance, node
+    double nn_dist = dist(query);
+    PtPtr nearest = center;
+    size_t evals = 1;
+    bool complete = true;
+    double unexpanded = std::numeric_limits<double>::infinity();
+
+    std::priority_queue<Entry, vector<Entry>, std::greater<Entry>> frontier;
+    frontier.push({nn_dist - radius, nn_dist, this});
+    while(!frontier.empty()){
+        auto [bound, top_dist, top] = frontier.top();
+        if(bound >= nn_dist)
+            break;
+        if(budget.exhausted(evals)){
+            unexpanded = bound;
+            complete = false;
+            break;
+        }
+        frontier.pop();
+        for(BallTreePtr child: {top->left.get(), top->right.get()}){
+            if(!child)
+                continue;
+            // a child that shares the center of top needs no new distance
+            double child_dist = top_dist;
+            if(child->center != top->center){
+                child_dist = child->dist(query);
+                evals++;
+            }
+            if(child_dist < nn_dist){
+                nearest = child->center;
+                nn_dist = child_dist;
+            }
+            if(child_dist - child->radius < nn_dist)
+                frontier.push({child_dist - child->radius, child_dist, child});
+        }
+    }
+    return {nearest, nn_dist, std::max(0.0, std::min(nn_dist, unexpanded)), complete};
+}
+
+template<size_t d, typename Metric, typename PtT>
+const PtT* BallTree<d, Metric, PtT>::farthest(PtPtr query){
     PtPtr farthest = nullptr;
     double fn_dist = 0.0;
     
@@ -179,8 +221,8 @@ const std::array<double, d>* BallTree<d, Metric>::farthest(PtPtr query){
     return farthest;
 }
 
-template <size_t d, typename Metric>
-vector<BallTree<d, Metric>*> BallTree<d, Metric>::range(PtPtr query, double q_radius){
+template<size_t d, typename Metric, typename PtT>
+vector<BallTree<d, Metric, PtT>*> BallTree<d, Metric, PtT>::range(PtPtr query, double q_radius){
     vector<BallTreePtr> output;
     
     auto is_viable = [&](BallTreePtr node){
@@ -198,9 +240,9 @@ vector<BallTree<d, Metric>*> BallTree<d, Metric>::range(PtPtr query, double q_ra
     return output;
 }
 
-template <size_t d, typename Metric>
+template<size_t d, typename Metric, typename PtT>
 template<typename Update, typename ViableCondition>
-void BallTree<d, Metric>::generic_search(Update update, ViableCondition is_viable){
+void BallTree<d, Metric, PtT>::generic_search(Update update, ViableCondition is_viable){
     auto viable = heap();
     while(!viable.empty()){
         auto top = viable.top();
@@ -213,8 +255,8 @@ void BallTree<d, Metric>::generic_search(Update update, ViableCondition is_viabl
     }
 }
 
-template <size_t d, typename Metric>
-vector<const std::array<double, d>*> BallTree<d, Metric>::points(){
+template<size_t d, typename Metric, typename PtT>
+vector<const PtT*> BallTree<d, Metric, PtT>::points(){
     deque<BallTree*> to_traverse({this});
     vector<PtPtr> output;
     while(!to_traverse.empty()){
@@ -228,4 +270,21 @@ vector<const std::array<double, d>*> BallTree<d, Metric>::points(){
         }
     }
     return output;
-}
\ No newline at end of file
+}
+template<size_t d, typename Metric, typename PtT>
+void memory_usage(const BallTree<d, Metric, PtT>* root, MemoryReport& report){
+    size_t num_nodes = 0;
+    std::stack<const BallTree<d, Metric, PtT>*> stk;
+    if(root)
+        stk.push(root);
+    while(!stk.empty()){
+        auto node = stk.top();
+        stk.pop();
+        num_nodes++;
+        if(node->left)
+            stk.push(node->left.get());
+        if(node->right)
+            stk.push(node->right.get());
+    }
+    report.add("BallTree nodes", num_nodes * sizeof(BallTree<d, Metric, PtT>));
+}
@@ -0,0 +1,78 @@
+/**
+ * @file budget.hpp
+ * @author Siddarth Sheth
+ * @brief Work limits for anytime queries and the certified answers they return.
+ */
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <chrono>
+#include <limits>
+#include <cstddef>
+
+/**
+ * @brief Limits on the work of a single query: distance evaluations and a deadline.
+ *
+ * The default budget is unlimited. A search checks its budget before it
+ * expands each node. An expansion costs one distance evaluation when the
+ * left child shares the center of its parent, as in greedy trees.
+ */
+struct SearchBudget {
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t max_evals = std::numeric_limits<std::size_t>::max();
+    Clock::time_point deadline = Clock::time_point::max();
+
+    static SearchBudget evals(std::size_t n) {
+        SearchBudget budget;
+        budget.max_evals = n;
+        return budget;
+    }
+
+    /**
+     * @brief A budget that ends t from now.
+     */
+    template<typename Rep, typename Period>
+    static SearchBudget timeout(std::chrono::duration<Rep, Period> t) {
+        SearchBudget budget;
+        budget.deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(t);
+        return budget;
+    }
+
+    /**
+     * @brief True once evals distance evaluations are made or the deadline has passed.
+     */
+    bool exhausted(std::size_t evals) const {
+        if (evals >= max_evals)
+            return true;
+        return deadline != Clock::time_point::max() && Clock::now() >= deadline;
+    }
+};
+
+/**
+ * @brief Result of a nearest neighbor search that may have stopped early.
+ *
+ * No point is closer to the query than lower_bound, so nn is at most
+ * ratio() times as far as the nearest neighbor.
+ *
+ * @tparam T Type of the answer: a position in G or a point pointer.
+ */
+template<typename T>
+struct AnytimeNN {
+    T nn;
+    double dist;
+    double lower_bound;
+    /**
+     * @brief False if the budget ran out before the search finished.
+     */
+    bool complete;
+
+    double ratio() const {
+        if (dist <= lower_bound)
+            return 1;
+        return lower_bound > 0 ? dist / lower_bound : std::numeric_limits<double>::infinity();
+    }
+};
+
+#endif // BUDGET_H
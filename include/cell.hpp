@@ -24,14 +24,17 @@ using namespace std;
  *
  * @tparam d The dimensionality of the space.
  * @tparam Metric The metric type used for distance calculations.
+ * @tparam PtT The stored point type; any type the Metric accepts, e.g. an index.
+ * @tparam Alloc Allocator of the points, rebound for the distances, e.g. a
+ *         HugePageAllocator so that large cells follow storage_policy().
  */
-template<size_t d, typename Metric>
+template<size_t d, typename Metric, typename PtT = std::array<double, d>, typename Alloc = std::allocator<PtT>>
 class Cell {
 public:
     /**
      * @brief Alias for a constant Point in d dimensions with the given Metric.
      */
-    using Pt = std::array<double, d>;
+    using Pt = PtT;
     
     /**
      * @brief Static counter for assigning unique IDs to cells.
@@ -53,12 +56,11 @@ public:
     /**
      * @brief Vector of pointers to points contained in the cell.
      */
-    std::vector<Pt> points;
+    std::vector<Pt, Alloc> points;
     /**
-     * @brief Pointer to the farthest point from the center in the cell.
+     * @brief compare_dist from the center to each point; the farthest point is first.
      */
-    std::vector<size_t> nbrs;
-    std::vector<double> distances;
+    std::vector<double, typename std::allocator_traits<Alloc>::template rebind_alloc<double>> distances;
     Metric metric;
 
     // /**
@@ -1,8 +1,8 @@
-template<size_t d, typename Metric>
-int Cell<d, Metric>::next_id = 0;
+template <std::size_t d, typename Metric, typename PtT, typename Alloc>
+int Cell<d, Metric, PtT, Alloc>::next_id = 0;
 
-template <size_t d, typename Metric>
-Cell<d,Metric>::Cell(Pt&& p, Metric metric) :
+template <std::size_t d, typename Metric, typename PtT, typename Alloc>
+Cell<d, Metric, PtT, Alloc>::Cell(Pt&& p, Metric metric) :
                     id(next_id++),
                     center(std::move(p)),
                     radius(0),
@@ -11,27 +11,27 @@ Cell<d,Metric>::Cell(Pt&& p, Metric metric) :
 }
 
 // template <size_t d, typename Metric>
-// double Cell<d,Metric>::dist(Pt& p) const {
+// double Cell<d, Metric, PtT, Alloc>::dist(Pt& p) const {
 //     return center.dist(p);
 // }
 
 // template <size_t d, typename Metric>
-// double Cell<d,Metric>::dist(const Cell& c) const {
+// double Cell<d, Metric, PtT, Alloc>::dist(const Cell& c) const {
 //     return center.dist(c.center);
 // }
 
 // template <size_t d, typename Metric>
-// double Cell<d,Metric>::compare_dist(Pt& p) const {
+// double Cell<d, Metric, PtT, Alloc>::compare_dist(Pt& p) const {
 //     return center.compare_dist(p);
 // }
 
 // template <size_t d, typename Metric>
-// double Cell<d,Metric>::compare_dist(const Cell& c) const {
+// double Cell<d, Metric, PtT, Alloc>::compare_dist(const Cell& c) const {
 //     return center.compare_dist(c.center);
 // }
 
-template <size_t d, typename Metric>
-void Cell<d,Metric>::update_radius() {
+template <std::size_t d, typename Metric, typename PtT, typename Alloc>
+void Cell<d, Metric, PtT, Alloc>::update_radius() {
     if(points.empty()){
         radius = 0;
         debug_log("update_radius: The cell " << center << " has no points and its radius is 0.");
@@ -46,8 +46,8 @@ void Cell<d,Metric>::update_radius() {
     }
 }
 
-template <size_t d, typename Metric>
-std::array<double, d> Cell<d,Metric>::pop_farthest(){
+template <std::size_t d, typename Metric, typename PtT, typename Alloc>
+PtT Cell<d, Metric, PtT, Alloc>::pop_farthest(){
     assert(!points.empty());
     Pt output = std::move(points[0]);
     points[0] =std::move(points.back());
@@ -58,14 +58,14 @@ std::array<double, d> Cell<d,Metric>::pop_farthest(){
     return output;
 }
 
-template <size_t d, typename Metric>
-size_t Cell<d,Metric>::size() const {
+template <std::size_t d, typename Metric, typename PtT, typename Alloc>
+size_t Cell<d, Metric, PtT, Alloc>::size() const {
     return points.size();
 }
 
 // // Compare Cells by id
 // template <size_t d, typename Metric>
-// bool Cell<d,Metric>::operator==(const Cell& other) const {
+// bool Cell<d, Metric, PtT, Alloc>::operator==(const Cell& other) const {
 //     return id == other.id;
 // }
 
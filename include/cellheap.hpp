@@ -0,0 +1,241 @@
+/**
+ * @file cellheap.hpp
+ * @author Siddarth Sheth
+ * @brief Priority queues of cells keyed by cell index and ordered by radius.
+ *
+ * CellHeap is an addressable binary max-heap that supports increasing and
+ * decreasing the radius of a cell in place. RadiusBucketQueue groups cells by
+ * geometrically quantized radius and returns a cell whose radius is within a
+ * (1+eps) factor of the maximum in amortized constant time.
+ */
+
+#ifndef CELLHEAP_H
+#define CELLHEAP_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cassert>
+#include "stats.hpp"
+
+/**
+ * @brief Addressable max-heap of cell indices keyed by radius.
+ *
+ * Ties between equal radii are broken towards the larger index. Every cell is
+ * in the heap exactly once, so no stale entries accumulate.
+ */
+class CellHeap {
+public:
+    /**
+     * @brief Insert cell i with the given radius.
+     */
+    void push(std::size_t i, double r) {
+        if (i >= pos.size()) {
+            pos.resize(i + 1, npos);
+            key.resize(i + 1, 0);
+        }
+        assert(pos[i] == npos);
+        key[i] = r;
+        pos[i] = heap.size();
+        heap.push_back(i);
+        sift_up(pos[i]);
+    }
+
+    /**
+     * @brief Change the radius of cell i, which must be in the heap.
+     */
+    void update(std::size_t i, double r) {
+        assert(i < pos.size() && pos[i] != npos);
+        double old = key[i];
+        key[i] = r;
+        if (r > old)
+            sift_up(pos[i]);
+        else if (r < old)
+            sift_down(pos[i]);
+    }
+
+    /**
+     * @brief Index of the cell with the largest radius.
+     */
+    std::size_t top() const { return heap.empty() ? npos : heap[0]; }
+
+    bool empty() const { return heap.empty(); }
+    std::size_t size() const { return heap.size(); }
+
+    /**
+     * @brief Bytes allocated by the heap.
+     */
+    std::size_t capacity_bytes() const {
+        return heap.capacity() * sizeof(std::size_t)
+             + pos.capacity() * sizeof(std::size_t)
+             + key.capacity() * sizeof(double);
+    }
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+private:
+    std::vector<std::size_t> heap;
+    std::vector<std::size_t> pos;
+    std::vector<double> key;
+
+    bool less(std::size_t a, std::size_t b) const {
+        if (key[a] != key[b])
+            return key[a] < key[b];
+        return a < b;
+    }
+
+    void place(std::size_t h, std::size_t i) {
+        heap[h] = i;
+        pos[i] = h;
+    }
+
+    void sift_up(std::size_t h) {
+        std::size_t i = heap[h];
+        while (h > 0) {
+            std::size_t parent = (h - 1) / 2;
+            if (!less(heap[parent], i))
+                break;
+            place(h, heap[parent]);
+            h = parent;
+        }
+        place(h, i);
+    }
+
+    void sift_down(std::size_t h) {
+        std::size_t i = heap[h];
+        std::size_t n = heap.size();
+        while (true) {
+            std::size_t child = 2 * h + 1;
+            if (child >= n)
+                break;
+            if (child + 1 < n && less(heap[child], heap[child + 1]))
+                child++;
+            if (!less(i, heap[child]))
+                break;
+            place(h, heap[child]);
+            h = child;
+        }
+        place(h, i);
+    }
+};
+
+/**
+ * @brief Bucket queue of cell indices over radii quantized by powers of (1+eps).
+ *
+ * Bucket k holds the cells with radius in (r_0/(1+eps)^(k+1), r_0/(1+eps)^k],
+ * where r_0 is the radius of the first cell pushed. top() returns some cell of
+ * the highest non-empty bucket, i.e. a cell whose radius is at least the maximum
+ * radius divided by (1+eps). Since radii in a greedy construction only shrink,
+ * the scan for the highest non-empty bucket only moves forward.
+ */
+class RadiusBucketQueue {
+public:
+    explicit RadiusBucketQueue(double eps = 0.1):
+                                log_base(std::log1p(eps)),
+                                r_0(0),
+                                first(0),
+                                num_cells(0){
+        assert(eps > 0);
+    }
+
+    void push(std::size_t i, double r) {
+        if (i >= bucket_of.size()) {
+            bucket_of.resize(i + 1, npos);
+            slot_of.resize(i + 1, npos);
+        }
+        if (num_cells == 0 && r_0 == 0 && r > 0)
+            r_0 = r;
+        insert(i, bucket(r));
+        num_cells++;
+    }
+
+    void update(std::size_t i, double r) {
+        std::size_t b = bucket(r);
+        if (b == bucket_of[i])
+            return;
+        remove(i);
+        insert(i, b);
+    }
+
+    /**
+     * @brief Index of a cell whose radius is within a (1+eps) factor of the largest.
+     */
+    std::size_t top() {
+        while (first < buckets.size() && buckets[first].empty()) {
+            stats_count(heap_skips, 1);
+            first++;
+        }
+        if (first < buckets.size())
+            return buckets[first].back();
+        if (!zero.empty())
+            return zero.back();
+        return empty_cells.empty() ? npos : empty_cells.back();
+    }
+
+    bool empty() const { return num_cells == 0; }
+    std::size_t size() const { return num_cells; }
+
+    std::size_t capacity_bytes() const {
+        std::size_t bytes = (bucket_of.capacity() + slot_of.capacity()
+                             + zero.capacity() + empty_cells.capacity()) * sizeof(std::size_t);
+        for (auto& b : buckets)
+            bytes += b.capacity() * sizeof(std::size_t);
+        return bytes + buckets.capacity() * sizeof(std::vector<std::size_t>);
+    }
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+private:
+    double log_base;
+    double r_0;
+    std::vector<std::vector<std::size_t>> buckets;
+    // cells of radius zero are kept apart; they are only returned once all else is empty
+    std::vector<std::size_t> zero;
+    // cells keyed with a negative radius (no points left) come after those of radius zero
+    std::vector<std::size_t> empty_cells;
+    std::vector<std::size_t> bucket_of;
+    std::vector<std::size_t> slot_of;
+    std::size_t first;
+    std::size_t num_cells;
+
+    static constexpr std::size_t zero_bucket = npos - 1;
+
+    std::size_t bucket(double r) const {
+        if (r < 0)
+            return npos;
+        if (r == 0)
+            return zero_bucket;
+        if (r >= r_0)
+            return 0;
+        return static_cast<std::size_t>(std::log(r_0 / r) / log_base);
+    }
+
+    std::vector<std::size_t>& list(std::size_t b) {
+        if (b == npos)
+            return empty_cells;
+        if (b == zero_bucket)
+            return zero;
+        if (b >= buckets.size())
+            buckets.resize(b + 1);
+        return buckets[b];
+    }
+
+    void insert(std::size_t i, std::size_t b) {
+        auto& l = list(b);
+        bucket_of[i] = b;
+        slot_of[i] = l.size();
+        l.push_back(i);
+        if (b < first)
+            first = b;
+    }
+
+    void remove(std::size_t i) {
+        auto& l = list(bucket_of[i]);
+        std::size_t last = l.back();
+        l[slot_of[i]] = last;
+        slot_of[last] = slot_of[i];
+        l.pop_back();
+    }
+};
+
+#endif // CELLHEAP_H
@@ -0,0 +1,52 @@
+/**
+ * @file dbscan.hpp
+ * @author Siddarth Sheth
+ * @brief DBSCAN clustering of the points of a fast_gt layout by dual-tree range counting.
+ *
+ * Neighborhoods are never materialized. A first walk over the pairs of nodes
+ * within eps (close_node_pairs) adds the size of each node to the counts of the
+ * points of the other, so whole subtrees are counted at once, and the counts
+ * decide which points are core points. A second walk over the same pairs
+ * merges the core points of close nodes into clusters and attaches the other
+ * points of those nodes as border points. It skips every pair of nodes that
+ * holds no core point.
+ */
+
+#ifndef DBSCAN_H
+#define DBSCAN_H
+
+#include "fast_search_impl.hpp"
+#include "disjointsets.hpp"
+#include <vector>
+#include <utility>
+
+/**
+ * @brief Label of the points that belong to no cluster.
+ */
+template<typename Idx = size_t>
+constexpr Idx dbscan_noise = static_cast<Idx>(-1);
+
+/**
+ * @brief DBSCAN over the points of a fast_gt layout.
+ *
+ * A point is a core point if at least min_pts points, itself included, lie
+ * within eps of it. Core points within eps of each other share a cluster, and
+ * any other point within eps of a core point joins one of the clusters of
+ * those core points.
+ *
+ * @param labels Cluster of each position in G, numbered from 0 in order of
+ *        their first position, or dbscan_noise<Idx>.
+ * @param core Whether each position in G is a core point.
+ * @param e As in ApxRngSearch: with e > 0, points up to (1 + e) eps apart may
+ *        count as neighbors, and whole nodes of radius at most e * eps / 4 are
+ *        taken at once.
+ * @return The number of clusters.
+ */
+template<typename PtT, typename Idx, typename Metric>
+size_t dbscan(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux,
+              double eps, size_t min_pts, std::vector<Idx>& labels, std::vector<bool>& core,
+              Metric metric, double e = 0);
+
+#include "dbscan_impl.hpp"
+
+#endif // DBSCAN_H
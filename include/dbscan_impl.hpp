@@ -0,0 +1,114 @@
+#include <algorithm>
+
+template<typename PtT, typename Idx, typename Metric>
+size_t dbscan(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux,
+              double eps, size_t min_pts, std::vector<Idx>& labels, std::vector<bool>& core,
+              Metric metric, double e){
+    using Node = GTSubtree<Idx>;
+    constexpr Idx none = static_cast<Idx>(-1);
+
+    size_t n = G.size();
+    labels.assign(n, dbscan_noise<Idx>);
+    core.assign(n, false);
+    if(n == 0)
+        return 0;
+    std::vector<Idx> start = node_starts(G, aux);
+
+    // Count the neighbors of every point. A pair of close nodes adds to the
+    // count of the nodes, and the counts are pushed down to the points after.
+    std::vector<Idx> count(aux.size(), 0);
+    close_node_pairs(G, aux, eps, metric, e,
+                     [](Node, Node){ return false; },
+                     [&](Node a){ count[a.s] += a.size(aux); },
+                     [&](Node a, Node b){
+                         count[a.s] += b.size(aux);
+                         count[b.s] += a.size(aux);
+                     });
+    // parents come before their children in aux
+    for(size_t s = 0; s < aux.size(); s++){
+        if(start[s] == none)
+            continue;
+        Node a{start[s], Idx(s)};
+        if(a.size(aux) == 1)
+            core[a.i] = count[s] >= min_pts;
+        else {
+            count[s + 1] += count[s];
+            count[a.right(G, aux).s] += count[s];
+        }
+    }
+
+    // number of core points of each node and one of them
+    std::vector<Idx> num_cores(aux.size()), some_core(aux.size());
+    for(size_t s = aux.size(); s-- > 0;){
+        if(start[s] == none)
+            continue;
+        Node a{start[s], Idx(s)};
+        if(a.size(aux) == 1){
+            num_cores[s] = core[a.i];
+            some_core[s] = core[a.i] ? a.i : none;
+        }
+        else {
+            Idx r = a.right(G, aux).s;
+            num_cores[s] = num_cores[s + 1] + num_cores[r];
+            some_core[s] = some_core[s + 1] != none ? some_core[s + 1] : some_core[r];
+        }
+    }
+
+    // Connect the core points of close nodes; border[k] is a core point within eps of k.
+    DisjointSets<Idx> clusters(n);
+    std::vector<Idx> border(n, none);
+    // Once a node is joined, its cores are in one cluster and all its other
+    // points are attached, and so for every node below it. The subtree of a
+    // node is a contiguous range of aux that ends where the next point starts.
+    std::vector<bool> joined(aux.size(), false);
+    auto join = [&](Node a, Idx c){
+        if(joined[a.s]){
+            if(num_cores[a.s])
+                clusters.unite(some_core[a.s], c);
+            return;
+        }
+        Idx end = a.i + a.size(aux);
+        for(Idx k = a.i; k < end; k++){
+            if(core[k])
+                clusters.unite(k, c);
+            else if(border[k] == none)
+                border[k] = c;
+        }
+        std::fill(joined.begin() + a.s, end < n ? joined.begin() + G[end].second : joined.end(), true);
+    };
+    // a pair adds nothing without a core point, or once both nodes are joined into one cluster
+    auto settled = [&](Node a, Node b){
+        if(num_cores[a.s] == 0 && num_cores[b.s] == 0)
+            return true;
+        if(!joined[a.s] || !joined[b.s])
+            return false;
+        return num_cores[a.s] == 0 || num_cores[b.s] == 0
+               || clusters.find(some_core[a.s]) == clusters.find(some_core[b.s]);
+    };
+    close_node_pairs(G, aux, eps, metric, e, settled,
+                     [&](Node a){
+                         if(num_cores[a.s])
+                             join(a, some_core[a.s]);
+                     },
+                     [&](Node a, Node b){
+                         if(num_cores[b.s])
+                             join(a, some_core[b.s]);
+                         if(num_cores[a.s])
+                             join(b, some_core[a.s]);
+                     });
+
+    // number the clusters in order of their first point
+    std::vector<Idx> cluster_id(n, none);
+    size_t num_clusters = 0;
+    for(Idx k = 0; k < n; k++){
+        Idx c = core[k] ? k : border[k];
+        if(c == none)
+            continue;
+        Idx root = clusters.find(c);
+        if(cluster_id[root] == none)
+            cluster_id[root] = num_clusters++;
+        labels[k] = cluster_id[root];
+    }
+    debug_log("dbscan: " << num_clusters << " clusters");
+    return num_clusters;
+}
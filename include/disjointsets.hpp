@@ -0,0 +1,64 @@
+/**
+ * @file disjointsets.hpp
+ * @author Siddarth Sheth
+ * @brief Union-find over elements numbered 0, 1, ..., n-1.
+ */
+
+#ifndef DISJOINTSETS_H
+#define DISJOINTSETS_H
+
+#include <vector>
+#include <numeric>
+#include <utility>
+#include <cstddef>
+
+/**
+ * @brief Disjoint sets with union by size and path halving.
+ *
+ * @tparam Id Integer type of the elements.
+ */
+template <typename Id = std::size_t>
+class DisjointSets {
+public:
+    explicit DisjointSets(std::size_t n): parent(n), sizes(n, 1), num_sets(n) {
+        std::iota(parent.begin(), parent.end(), Id(0));
+    }
+
+    /**
+     * @brief Representative of the set of x.
+     */
+    Id find(Id x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    /**
+     * @brief Merge the sets of x and y.
+     * @return False if they were already the same set.
+     */
+    bool unite(Id x, Id y) {
+        x = find(x);
+        y = find(y);
+        if (x == y)
+            return false;
+        if (sizes[x] < sizes[y])
+            std::swap(x, y);
+        parent[y] = x;
+        sizes[x] += sizes[y];
+        num_sets--;
+        return true;
+    }
+
+    std::size_t size(Id x) { return sizes[find(x)]; }
+    std::size_t count() const { return num_sets; }
+
+private:
+    std::vector<Id> parent;
+    std::vector<std::size_t> sizes;
+    std::size_t num_sets;
+};
+
+#endif // DISJOINTSETS_H
@@ -0,0 +1,45 @@
+/**
+ * @file emst.hpp
+ * @author Siddarth Sheth
+ * @brief Minimum spanning tree of a point set by dual-tree Boruvka on the fast_gt layout.
+ *
+ * Every Boruvka round finds, for each component, its shortest edge to another
+ * component, and then merges along those edges. The search of a round is a
+ * batch nearest-neighbor search of the layout against itself in which every
+ * node caches the component of its points, or none if they are mixed. A
+ * candidate node is dropped when it lies in the same component as the query
+ * node, or when it is too far to beat the shortest edge found so far for that
+ * component. There are O(log n) rounds.
+ */
+
+#ifndef EMST_H
+#define EMST_H
+
+#include "fast_search_impl.hpp"
+#include "disjointsets.hpp"
+#include <vector>
+#include <utility>
+
+/**
+ * @brief An edge between the points at positions a and b of a layout.
+ */
+template<typename Idx = size_t>
+struct MSTEdge {
+    Idx a, b;
+    double dist;
+};
+
+/**
+ * @brief Minimum spanning tree of the points of a fast_gt layout.
+ *
+ * @param output The n-1 edges of the tree, with ends as positions in G, sorted
+ *        by increasing distance. Merging along them in order gives the
+ *        single-linkage dendrogram.
+ */
+template<typename PtT, typename Idx, typename Metric>
+void emst(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux,
+          std::vector<MSTEdge<Idx>>& output, Metric metric);
+
+#include "emst_impl.hpp"
+
+#endif // EMST_H
@@ -0,0 +1,151 @@
+#include <stack>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+
+template<typename PtT, typename Idx, typename Metric>
+void emst(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux,
+          std::vector<MSTEdge<Idx>>& output, Metric metric){
+    using Node = GTSubtree<Idx>;
+    using Cand = std::pair<Node, double>;               // candidate node, distance between the centers
+    using Search = std::pair<Node, std::vector<Cand>>;
+    constexpr Idx mixed = static_cast<Idx>(-1);
+    // node_starts gives the filler entry after each left chain this start
+    constexpr Idx filler = static_cast<Idx>(-1);
+    constexpr double inf = std::numeric_limits<double>::infinity();
+
+    size_t n = G.size();
+    output.clear();
+    if(n < 2)
+        return;
+    output.reserve(n - 1);
+
+    std::vector<Idx> start = node_starts(G, aux);
+    DisjointSets<Idx> components(n);
+    std::vector<Idx> pt_comp(n), node_comp(aux.size());
+    std::vector<MSTEdge<Idx>> best(n);
+    std::vector<MSTEdge<Idx>> round_edges;
+    // larger candidates are split first, and among nodes of radius 0 the duplicates before the leaves
+    auto smaller = [&](const Cand& u, const Cand& v){
+        double u_rad = u.first.rad(aux), v_rad = v.first.rad(aux);
+        return u_rad < v_rad || (u_rad == v_rad && u.first.size(aux) < v.first.size(aux));
+    };
+    auto by_dist = [](const MSTEdge<Idx>& u, const MSTEdge<Idx>& v){ return u.dist < v.dist; };
+
+    // an edge is a candidate for the components of both of its ends
+    auto offer = [&](Idx a, Idx b, double dist){
+        Idx c_a = pt_comp[a], c_b = pt_comp[b];
+        if(c_a == c_b)
+            return;
+        if(dist < best[c_a].dist)
+            best[c_a] = {a, b, dist};
+        if(dist < best[c_b].dist)
+            best[c_b] = {a, b, dist};
+    };
+
+    for(size_t round = 0; components.count() > 1; round++){
+        for(Idx i = 0; i < n; i++){
+            pt_comp[i] = components.find(i);
+            best[i].dist = inf;
+        }
+        for(size_t s = aux.size(); s-- > 0;){
+            if(start[s] == filler)
+                continue;
+            Node a{start[s], Idx(s)};
+            if(a.size(aux) == 1)
+                node_comp[s] = pt_comp[a.i];
+            else {
+                Idx l = node_comp[s + 1], r = node_comp[a.right(G, aux).s];
+                node_comp[s] = l == r ? l : mixed;
+            }
+        }
+
+        std::stack<Search> to_process;
+        to_process.push({Node::root(), {{Node::root(), 0}}});
+        while(!to_process.empty()){
+            Node a = to_process.top().first;
+            std::vector<Cand> cands = std::move(to_process.top().second);
+            to_process.pop();
+            const auto& a_ctr = G[a.i].first;
+
+            // The two closest centers in different components: every point of a
+            // has a point of another component within d_2 + a_rad.
+            double d_1 = inf, d_2 = inf;
+            Idx c_1 = mixed;
+            // beyond this, a pair of points of a and b cannot give a new shortest edge
+            auto threshold = [&](){
+                Idx c = node_comp[a.s];
+                return c == mixed ? d_2 + a.rad(aux) : best[c].dist;
+            };
+            auto drop = [&](Node b, double b_dist){
+                Idx c = node_comp[a.s];
+                if(c != mixed && node_comp[b.s] == c)
+                    return true;
+                return b_dist - a.rad(aux) - b.rad(aux) > threshold();
+            };
+            // a distance is only offered as an edge when it is exact
+            auto evaluate = [&](Node b){
+                double bound = threshold() + a.rad(aux) + b.rad(aux);
+                double dist = metric.dist_bounded(a_ctr, G[b.i].first, bound);
+                if(dist <= bound){
+                    offer(a.i, b.i, dist);
+                    Idx c = pt_comp[b.i];
+                    if(dist < d_1){
+                        if(c != c_1)
+                            d_2 = d_1;
+                        d_1 = dist;
+                        c_1 = c;
+                    }
+                    else if(c != c_1 && dist < d_2)
+                        d_2 = dist;
+                }
+                return dist;
+            };
+
+            for(auto& [b, b_dist]: cands)
+                b_dist = evaluate(b);
+            std::make_heap(cands.begin(), cands.end(), smaller);
+
+            while(!cands.empty()){
+                auto [b, b_dist] = cands.front();
+                if(drop(b, b_dist)){
+                    std::pop_heap(cands.begin(), cands.end(), smaller);
+                    cands.pop_back();
+                }
+                // a node of duplicates has radius 0, but its points still need edges between them
+                else if(b.rad(aux) > a.rad(aux) || (a.size(aux) == 1 && b.size(aux) > 1)){
+                    std::pop_heap(cands.begin(), cands.end(), smaller);
+                    cands.pop_back();
+                    // the left child shares the center of b
+                    Node l = b.left(), r = b.right(G, aux);
+                    double r_dist = evaluate(r);
+                    for(auto [c, c_dist]: {Cand{l, b_dist}, Cand{r, r_dist}}){
+                        if(!drop(c, c_dist)){
+                            cands.push_back({c, c_dist});
+                            std::push_heap(cands.begin(), cands.end(), smaller);
+                        }
+                    }
+                }
+                else if(a.size(aux) > 1){
+                    to_process.push({a.right(G, aux), cands});
+                    a = a.left();
+                }
+                else
+                    break;
+            }
+        }
+
+        // merge along the shortest edges, lightest first
+        round_edges.clear();
+        for(Idx c = 0; c < n; c++)
+            if(pt_comp[c] == c && best[c].dist < inf)
+                round_edges.push_back(best[c]);
+        assert(!round_edges.empty());
+        std::sort(round_edges.begin(), round_edges.end(), by_dist);
+        for(auto& e: round_edges)
+            if(components.unite(e.a, e.b))
+                output.push_back(e);
+        debug_log("emst: round " << round << " leaves " << components.count() << " components");
+    }
+    std::sort(output.begin(), output.end(), by_dist);
+}
@@ -0,0 +1,300 @@
+/**
+ * @file external.hpp
+ * @author Siddarth Sheth
+ * @brief External-memory variant of Clarkson's algorithm for inputs larger than RAM.
+ *
+ * Points are streamed from a raw binary file of n rows of d scalars. The points
+ * owned by a cell are kept in sequential runs of a scratch file and only small
+ * per-cell buffers stay resident. The greedy permutation is written to an output
+ * file of the same format, which is memory-mapped and doubles as the storage of
+ * the cell centers.
+ *
+ * Limits: only the point rows leave memory. A cell keeps its radius, size,
+ * heap slot and input row in RAM (about 80 bytes with the list header), its
+ * neighbor list in a shared ChunkedAdjacency pool, and, while it still owns
+ * points, a Spill header that locates its farthest record on disk. Measured with
+ * memory_usage on 10^5 and 2*10^5 clustered 96-d float rows, the peak is 380 to
+ * 420 bytes per row, of which about 60% is neighbor lists; it does not shrink
+ * with n, so 10^9 rows need several hundred GB and the build only fits inputs of
+ * a few 10^8 rows on a 128 GB machine. Runs shorter than min_run_length are
+ * merged whenever their cell is streamed, and cells smaller than that stay in
+ * their buffers, so rebalances keep reading long runs; the mapped centers are
+ * still read at random.
+ */
+
+#ifndef EXTERNAL_H
+#define EXTERNAL_H
+
+#include "point.hpp"
+#include "cellheap.hpp"
+#include "adjacency.hpp"
+#include "utils.hpp"
+#include <array>
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <limits>
+#include <cstdint>
+
+/**
+ * @brief Tuning knobs for the external-memory build.
+ */
+struct ExternalConfig {
+    /**
+     * @brief Path of the scratch file holding spilled runs (removed when done).
+     */
+    std::string scratch_path = "greedy_spill.bin";
+    /**
+     * @brief Maximum number of records in a single on-disk run.
+     */
+    std::size_t run_length = 1 << 14;
+    /**
+     * @brief Number of buffered records after which the largest buffers are spilled.
+     */
+    std::size_t resident_budget = 1 << 26;
+    /**
+     * @brief Runs shorter than this are merged back into the buffer of their
+     * cell whenever the cell is streamed, so that cells are read in long runs.
+     */
+    std::size_t min_run_length = 1 << 10;
+};
+
+/**
+ * @brief A point owned by a cell, as stored in the scratch file.
+ *
+ * @tparam d Dimensionality of the points.
+ * @tparam Scalar Coordinate type of the input file.
+ */
+template <std::size_t d, typename Scalar>
+struct SpillRecord {
+    std::array<Scalar, d> pt;
+    /**
+     * @brief compare_dist from the point to the center of its cell.
+     */
+    double dist;
+    /**
+     * @brief Row of the point in the input file.
+     */
+    std::size_t id;
+};
+
+/**
+ * @brief Append-only file of fixed-size records grouped into runs.
+ *
+ * Runs that are no longer referenced are only counted as dead; the owner calls
+ * compact() to rewrite the live runs contiguously once enough space is wasted.
+ */
+template <typename Record>
+class RunStore {
+public:
+    struct Run {
+        std::streamoff offset;
+        std::size_t count;
+    };
+
+    explicit RunStore(const std::string& path);
+    ~RunStore();
+
+    Run write(const Record* recs, std::size_t count);
+    void read(const Run& run, std::vector<Record>& output);
+    /**
+     * @brief Read the record at position k of run.
+     */
+    Record read(const Run& run, std::size_t k);
+    void release(const Run& run) { num_dead += run.count; num_live -= run.count; }
+
+    std::size_t live() const { return num_live; }
+    std::size_t dead() const { return num_dead; }
+
+    /**
+     * @brief Rewrite all live runs into a fresh file.
+     * @param for_each_list Callable that invokes its argument on every
+     *        std::vector<Run> that is still in use.
+     */
+    template <typename ForEachList>
+    void compact(ForEachList&& for_each_list);
+
+private:
+    std::string path;
+    std::fstream file;
+    std::streamoff end;
+    std::size_t num_live, num_dead;
+};
+
+/**
+ * @brief Neighbor graph whose cells keep their points on disk.
+ *
+ * @tparam d Dimensionality of the space.
+ * @tparam Scalar Coordinate type of the input and output files.
+ * @tparam Metric Metric type for distance calculations.
+ * @tparam Idx Integer type of the cell ids in the neighbor lists.
+ *
+ * Mirrors NeighborGraph: the cell heap and the neighbor lists are in memory,
+ * the centers are in the mapped output file, and the points of a cell live in
+ * its runs and a small write buffer. Every rebalance streams the runs of the
+ * donor cell in order. A cell that runs out of points gives up its neighbor
+ * list and its Spill, so only the cells that still own points cost more than
+ * their fixed per-cell fields.
+ */
+template <std::size_t d, typename Scalar, typename Metric, typename Idx = std::uint32_t>
+class ExternalNeighborGraph {
+    using Pt = std::array<double, d>;
+    using Record = SpillRecord<d, Scalar>;
+    using Run = typename RunStore<Record>::Run;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief Point storage of a cell that still owns points.
+     */
+    struct Spill {
+        std::vector<Run> runs;
+        std::vector<Record> buffer;
+        /**
+         * @brief compare_dist, distance and row of the farthest point.
+         */
+        double far_dist = 0;
+        double far_radius = 0;
+        std::size_t far_id = 0;
+        /**
+         * @brief Where the farthest record is: runs[far_run], or the buffer if
+         * far_run is npos, at position far_slot. It is read back when promoted.
+         */
+        std::size_t far_run = npos;
+        std::size_t far_slot = 0;
+        /**
+         * @brief Id of a point promoted to a center but not yet dropped from the runs.
+         */
+        std::size_t popped = npos;
+    };
+
+    struct ExtCell {
+        double radius = 0;
+        Idx size = 0;
+        std::unique_ptr<Spill> spill;
+    };
+
+public:
+    /**
+     * @brief Create the root cell from the points in the input file.
+     * @param input Raw binary file with n rows of d Scalars.
+     * @param output File that receives the greedy permutation in the same format.
+     *
+     * Throws std::length_error if the n cells cannot be numbered by Idx.
+     */
+    ExternalNeighborGraph(const std::string& input,
+                          const std::string& output,
+                          Metric metric,
+                          ExternalConfig config);
+    ~ExternalNeighborGraph();
+
+    ExternalNeighborGraph(const ExternalNeighborGraph&) = delete;
+    ExternalNeighborGraph& operator=(const ExternalNeighborGraph&) = delete;
+
+    std::size_t size() const { return n; }
+    std::size_t heap_top();
+    void add_cell();
+
+    /**
+     * @brief Move out the input row of the center of every cell, in cell order.
+     */
+    void get_rows(std::vector<Idx>& output) { output = std::move(rows); }
+
+    /**
+     * @brief Add the bytes held in memory by the cells, neighbor lists, cell heap and buffers to report.
+     */
+    void memory_usage(MemoryReport& report) const;
+
+private:
+    Metric metric;
+    ExternalConfig config;
+    RunStore<Record> store;
+
+    std::size_t n;
+    int out_fd;
+    Scalar* centers;
+
+    std::vector<ExtCell> cells;
+    std::vector<Idx> rows;
+    ChunkedAdjacency<Idx> nbrs;
+    CellHeap cell_heap;
+    std::vector<std::size_t> affected_cells;
+    std::vector<std::size_t> new_nbrs;
+    std::vector<Record> chunk;
+    std::size_t resident;
+    /**
+     * @brief visited[i] == epoch iff cell i was already seen by the current nbr_nbr_update.
+     */
+    std::vector<std::uint32_t> visited;
+    std::uint32_t epoch;
+
+    Pt center(std::size_t i) const;
+    static Pt to_pt(const std::array<Scalar, d>& p);
+
+    void set_far(std::size_t i, const Record& rec, std::size_t run, std::size_t slot);
+    void push(std::size_t i, const Record& rec);
+    void flush(std::size_t i);
+    void spill_all();
+    void compact();
+
+    void rebalance(std::size_t i, std::size_t j, double ctr_dist);
+    void point_location(std::size_t cell_i, std::size_t par_i);
+    void nbr_nbr_update(std::size_t cell_i);
+    void prune_edges();
+
+    /**
+     * @brief Key of cell i in the cell heap: its radius, or -1 once it has no points.
+     *
+     * A cell whose remaining points all coincide with its center has radius 0
+     * too, and must be taken before the empty cells.
+     */
+    inline double heap_key(std::size_t i) const {
+        return cells[i].size ? cells[i].radius : -1;
+    }
+
+    inline bool is_close_enough(const std::size_t i, const std::size_t j) const {
+        double i_r = cells[i].radius;
+        double j_r = cells[j].radius;
+        double min_r = std::min(i_r, j_r);
+        double max_r = std::max(i_r, j_r);
+        return min_r > 0 && metric.dist(center(i), center(j)) <= i_r + j_r + max_r;
+    }
+};
+
+/**
+ * @brief Clarkson's algorithm on a dataset stored on disk.
+ *
+ * @tparam d Dimensionality of the points.
+ * @tparam Scalar Coordinate type of the files (e.g. float).
+ * @tparam Metric Metric type for distance calculations.
+ * @param input Raw binary file with n rows of d Scalars.
+ * @param output File to write the points in greedy order.
+ * @param perm Output vector; perm[i] is the row of the input file written as row i of output.
+ * @param pred Output vector of predecessor indices, as in clarkson().
+ *
+ * Throws std::runtime_error if a file cannot be read, written or mapped, and
+ * std::length_error if the rows cannot be numbered by Idx.
+ */
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void clarkson_external(const std::string& input,
+                       const std::string& output,
+                       std::vector<Idx>& perm,
+                       std::vector<Idx>& pred,
+                       Metric metric,
+                       ExternalConfig config = ExternalConfig());
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void clarkson_external(const std::string& input,
+                       const std::string& output,
+                       std::vector<Idx>& pred,
+                       Metric metric,
+                       ExternalConfig config = ExternalConfig()){
+    std::vector<Idx> perm;
+    clarkson_external<d, Scalar>(input, output, perm, pred, metric, std::move(config));
+}
+
+#include "external_impl.hpp"
+
+#endif // EXTERNAL_H
@@ -0,0 +1,464 @@
+#include <cstdio>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+template <typename Record>
+RunStore<Record>::RunStore(const std::string& path):
+                    path(path), end(0), num_live(0), num_dead(0){
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file)
+        throw std::runtime_error("RunStore: cannot open scratch file " + path);
+}
+
+template <typename Record>
+RunStore<Record>::~RunStore(){
+    file.close();
+    std::remove(path.c_str());
+}
+
+template <typename Record>
+typename RunStore<Record>::Run RunStore<Record>::write(const Record* recs, std::size_t count){
+    Run run({end, count});
+    file.seekp(end);
+    file.write(reinterpret_cast<const char*>(recs), count * sizeof(Record));
+    if(!file)
+        throw std::runtime_error("RunStore: write failed on " + path);
+    end += count * sizeof(Record);
+    num_live += count;
+    return run;
+}
+
+template <typename Record>
+void RunStore<Record>::read(const Run& run, std::vector<Record>& output){
+    output.resize(run.count);
+    file.seekg(run.offset);
+    file.read(reinterpret_cast<char*>(output.data()), run.count * sizeof(Record));
+    if(!file)
+        throw std::runtime_error("RunStore: read failed on " + path);
+}
+
+template <typename Record>
+Record RunStore<Record>::read(const Run& run, std::size_t k){
+    Record output;
+    file.seekg(run.offset + static_cast<std::streamoff>(k * sizeof(Record)));
+    file.read(reinterpret_cast<char*>(&output), sizeof(Record));
+    if(!file)
+        throw std::runtime_error("RunStore: read failed on " + path);
+    return output;
+}
+
+template <typename Record>
+template <typename ForEachList>
+void RunStore<Record>::compact(ForEachList&& for_each_list){
+    debug_log("RunStore: compacting " << num_live << " live and " << num_dead << " dead records");
+    std::string tmp_path = path + ".compact";
+    std::fstream tmp(tmp_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!tmp)
+        throw std::runtime_error("RunStore: cannot open scratch file " + tmp_path);
+
+    std::streamoff tmp_end = 0;
+    std::vector<Record> recs;
+    // copy the runs of each list back to back so that a cell is read sequentially
+    for_each_list([&](std::vector<Run>& runs){
+        for(Run& run: runs){
+            read(run, recs);
+            tmp.write(reinterpret_cast<const char*>(recs.data()), run.count * sizeof(Record));
+            run.offset = tmp_end;
+            tmp_end += run.count * sizeof(Record);
+        }
+    });
+    if(!tmp)
+        throw std::runtime_error("RunStore: write failed on " + tmp_path);
+
+    file.close();
+    tmp.close();
+    if(std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("RunStore: cannot replace " + path);
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    if(!file)
+        throw std::runtime_error("RunStore: cannot reopen scratch file " + path);
+    end = tmp_end;
+    num_dead = 0;
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+ExternalNeighborGraph<d, Scalar, Metric, Idx>::ExternalNeighborGraph(
+                                        const std::string& input,
+                                        const std::string& output,
+                                        Metric metric,
+                                        ExternalConfig config):
+                                        metric(metric),
+                                        config(config),
+                                        store(config.scratch_path),
+                                        n(0),
+                                        out_fd(-1),
+                                        centers(nullptr),
+                                        resident(0),
+                                        epoch(0){
+    constexpr std::size_t row_bytes = d * sizeof(Scalar);
+    std::ifstream in(input, std::ios::binary | std::ios::ate);
+    if(!in)
+        throw std::runtime_error("ExternalNeighborGraph: cannot open " + input);
+    std::streamoff bytes = in.tellg();
+    if(bytes % row_bytes != 0)
+        throw std::runtime_error("ExternalNeighborGraph: size of " + input + " is not a multiple of the row size");
+    n = bytes / row_bytes;
+    // checked once here, so that the neighbor lists can store ids unchecked
+    if(n > 0 && n - 1 > ChunkedAdjacency<Idx>::max_id)
+        throw std::length_error("ExternalNeighborGraph: too many rows for the index type");
+
+    // the output file holds one row per center and is mapped for random access
+    out_fd = ::open(output.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(out_fd < 0)
+        throw std::runtime_error("ExternalNeighborGraph: cannot open " + output);
+    if(n == 0)
+        return;
+    if(::ftruncate(out_fd, n * row_bytes) != 0)
+        throw std::runtime_error("ExternalNeighborGraph: cannot resize " + output);
+    void* addr = ::mmap(nullptr, n * row_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+    if(addr == MAP_FAILED)
+        throw std::runtime_error("ExternalNeighborGraph: cannot map " + output);
+    centers = static_cast<Scalar*>(addr);
+
+    cells.reserve(n);
+    rows.reserve(n);
+    nbrs.reserve(n);
+    visited.reserve(n);
+    cells.emplace_back();
+    rows.push_back(0);
+    nbrs.add_vertex();
+    nbrs.push_back(0, 0);
+    visited.push_back(0);
+
+    // the first row becomes the center of the root cell
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(centers), row_bytes);
+    Pt root_pt = center(0);
+
+    // stream the remaining rows into the root cell
+    std::vector<std::array<Scalar, d>> input_rows;
+    for(std::size_t start = 1; start < n; start += input_rows.size()){
+        input_rows.resize(std::min(config.run_length, n - start));
+        in.read(reinterpret_cast<char*>(input_rows.data()), input_rows.size() * row_bytes);
+        if(!in)
+            throw std::runtime_error("ExternalNeighborGraph: read failed on " + input);
+        for(std::size_t k = 0; k < input_rows.size(); k++)
+            push(0, Record({input_rows[k], metric.compare_dist(root_pt, to_pt(input_rows[k])), start + k}));
+    }
+
+    ExtCell& root = cells[0];
+    root.radius = root.size ? root.spill->far_radius : 0;
+    cell_heap.push(0, heap_key(0));
+
+    debug_log("ExternalNeighborGraph: Root cell created with " << root.size << " points.");
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+ExternalNeighborGraph<d, Scalar, Metric, Idx>::~ExternalNeighborGraph(){
+    if(centers)
+        ::munmap(centers, n * d * sizeof(Scalar));
+    if(out_fd >= 0)
+        ::close(out_fd);
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+std::array<double, d> ExternalNeighborGraph<d, Scalar, Metric, Idx>::to_pt(const std::array<Scalar, d>& p){
+    Pt output;
+    for(std::size_t k = 0; k < d; k++)
+        output[k] = p[k];
+    return output;
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+std::array<double, d> ExternalNeighborGraph<d, Scalar, Metric, Idx>::center(std::size_t i) const {
+    Pt output;
+    const Scalar* row = centers + i * d;
+    for(std::size_t k = 0; k < d; k++)
+        output[k] = row[k];
+    return output;
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::set_far(std::size_t i, const Record& rec, std::size_t run, std::size_t slot){
+    // only the location of the record is kept; its radius is computed while it is at hand
+    Spill& s = *cells[i].spill;
+    s.far_dist = rec.dist;
+    s.far_radius = metric.dist(center(i), to_pt(rec.pt));
+    s.far_id = rec.id;
+    s.far_run = run;
+    s.far_slot = slot;
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::push(std::size_t i, const Record& rec){
+    ExtCell& c = cells[i];
+    if(!c.spill)
+        c.spill = std::make_unique<Spill>();
+    Spill& s = *c.spill;
+    if(c.size == 0 || rec.dist > s.far_dist)
+        set_far(i, rec, npos, s.buffer.size());
+    s.buffer.push_back(rec);
+    c.size++;
+    resident++;
+    if(s.buffer.size() >= config.run_length)
+        flush(i);
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::flush(std::size_t i){
+    Spill& s = *cells[i].spill;
+    if(s.buffer.empty())
+        return;
+    if(s.far_run == npos)
+        s.far_run = s.runs.size();
+    s.runs.push_back(store.write(s.buffer.data(), s.buffer.size()));
+    resident -= s.buffer.size();
+    std::vector<Record>().swap(s.buffer);
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::spill_all(){
+    debug_log("spill_all: Spilling " << resident << " buffered records");
+    // flush the largest buffers until half of the budget is free; the small
+    // ones would only add short runs that are later read one seek each
+    std::vector<std::size_t> buffered;
+    for(std::size_t i = 0; i < cells.size(); i++)
+        if(cells[i].spill && !cells[i].spill->buffer.empty())
+            buffered.push_back(i);
+    std::sort(buffered.begin(), buffered.end(), [&](std::size_t i, std::size_t j){
+        return cells[i].spill->buffer.size() > cells[j].spill->buffer.size();
+    });
+    for(std::size_t i: buffered){
+        if(resident <= config.resident_budget / 2)
+            break;
+        flush(i);
+    }
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::compact(){
+    store.compact([&](auto&& f){
+        for(auto& c: cells)
+            if(c.spill && !c.spill->runs.empty())
+                f(c.spill->runs);
+    });
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::rebalance(std::size_t i, std::size_t j, double ctr_dist){
+    ExtCell& b = cells[j];
+    if(!b.spill)
+        return;
+
+    debug_log("rebalance: PL on " << b.size << " points from cell " << j << " to cell " << i);
+
+    Pt a_center = center(i);
+    // points within half the center distance of b cannot move to a
+    double stay_dist = metric.to_compare_dist(ctr_dist / 2);
+    // shorter runs are merged through the buffer, so that b is read back in long runs
+    std::size_t min_run = std::min(config.min_run_length, config.run_length);
+    Spill& s = *b.spill;
+    std::vector<Run> runs = std::move(s.runs);
+    std::vector<Record> buffer = std::move(s.buffer);
+    s.runs.clear();
+    s.buffer.clear();
+    resident -= buffer.size();
+    std::size_t popped = s.popped;
+    s.popped = npos;
+    b.size = 0;
+    bool moved = false;
+
+    // returns true if the record leaves b, either to a or as a promoted center
+    auto leaves = [&](Record& rec){
+        if(rec.id == popped)
+            return true;
+        if(rec.dist < stay_dist)
+            return false;
+        double a_dist = metric.compare_dist_bounded(a_center, to_pt(rec.pt), rec.dist);
+        if(a_dist < rec.dist){
+            rec.dist = a_dist;
+            push(i, rec);
+            moved = true;
+            return true;
+        }
+        return false;
+    };
+
+    for(const Run& run: runs){
+        store.read(run, chunk);
+        // the records that stay are compacted to the front of chunk
+        std::size_t kept = 0;
+        for(std::size_t k = 0; k < chunk.size(); k++)
+            if(!leaves(chunk[k]))
+                chunk[kept++] = chunk[k];
+        if(kept == chunk.size() && run.count >= min_run){
+            // keep the run on disk untouched
+            for(std::size_t k = 0; k < kept; k++)
+                if(b.size++ == 0 || chunk[k].dist > s.far_dist)
+                    set_far(j, chunk[k], s.runs.size(), k);
+            s.runs.push_back(run);
+            continue;
+        }
+        store.release(run);
+        for(std::size_t k = 0; k < kept; k++)
+            push(j, chunk[k]);
+    }
+    for(Record& rec: buffer)
+        if(!leaves(rec))
+            push(j, rec);
+
+    if(b.size == 0){
+        b.spill.reset();
+        b.radius = 0;
+    }
+    else
+        b.radius = s.far_radius;
+    cell_heap.update(j, heap_key(j));
+
+    if(moved)
+        affected_cells.push_back(j);
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::point_location(std::size_t cell_i, std::size_t par_i){
+    affected_cells.clear();
+    bool par_seen = false;
+    Pt cell_center = center(cell_i);
+    for(std::size_t i: nbrs[par_i]){
+        double ctr_dist = metric.dist(cell_center, center(i));
+        // no point of cell i can move if the new center is beyond twice its radius,
+        // but the parent must be streamed to drop the point promoted to the new center
+        if(i != par_i && ctr_dist > 2 * cells[i].radius)
+            continue;
+        rebalance(cell_i, i, ctr_dist);
+        par_seen |= (i == par_i);
+    }
+    if(!par_seen)
+        rebalance(cell_i, par_i, metric.dist(cell_center, center(par_i)));
+
+    ExtCell& c = cells[cell_i];
+    c.radius = c.size ? c.spill->far_radius : 0;
+    if(std::find(affected_cells.begin(), affected_cells.end(), par_i) == affected_cells.end())
+        affected_cells.push_back(par_i);
+
+    if(resident > config.resident_budget)
+        spill_all();
+    if(store.dead() > store.live() && store.dead() > config.run_length)
+        compact();
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::nbr_nbr_update(std::size_t cell_i){
+    // a new epoch invalidates all marks at once; reset them only when the counter wraps
+    if(++epoch == 0){
+        std::fill(visited.begin(), visited.end(), 0);
+        epoch = 1;
+    }
+    visited[cell_i] = epoch;
+
+    for(std::size_t i: affected_cells)
+        for(std::size_t j: nbrs[i]){
+            if(visited[j] == epoch)
+                continue;
+            visited[j] = epoch;
+            if(is_close_enough(cell_i, j))
+                new_nbrs.push_back(j);
+        }
+
+    // adding edges may move lists in the pool, so connect them only after the scan
+    nbrs.reserve(cell_i, new_nbrs.size());
+    for(std::size_t j: new_nbrs){
+        nbrs.push_back(cell_i, j);
+        nbrs.push_back(j, cell_i);
+    }
+    new_nbrs.clear();
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::prune_edges(){
+    for(std::size_t i: affected_cells){
+        // a cell without points is never read again, so its list goes back to the pool
+        if(cells[i].size == 0){
+            nbrs.clear(i);
+            continue;
+        }
+        nbrs.remove_if(i, [&](const std::size_t j){
+            return !(is_close_enough(i, j));
+        });
+    }
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+std::size_t ExternalNeighborGraph<d, Scalar, Metric, Idx>::heap_top(){
+    return cell_heap.top();
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::add_cell(){
+    std::size_t par_i = heap_top();
+    Spill& s = *cells[par_i].spill;
+
+    // promote the farthest point of the parent, read back from where it is kept;
+    // its record is dropped lazily when the parent is streamed
+    std::size_t cell_i = cells.size();
+    Record far = s.far_run == npos ? s.buffer[s.far_slot] : store.read(s.runs[s.far_run], s.far_slot);
+    std::copy(far.pt.begin(), far.pt.end(), centers + cell_i * d);
+    s.popped = far.id;
+    cells[par_i].size--;
+
+    cells.emplace_back();
+    rows.push_back(static_cast<Idx>(far.id));
+    nbrs.add_vertex();
+    nbrs.push_back(cell_i, cell_i);
+    visited.push_back(0);
+
+    point_location(cell_i, par_i);
+    nbr_nbr_update(cell_i);
+    prune_edges();
+    cell_heap.push(cell_i, heap_key(cell_i));
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void ExternalNeighborGraph<d, Scalar, Metric, Idx>::memory_usage(MemoryReport& report) const{
+    std::size_t spills = 0, runs = 0, buffers = 0;
+    for(auto& c: cells)
+        if(c.spill){
+            spills += sizeof(Spill);
+            runs += capacity_bytes(c.spill->runs);
+            buffers += capacity_bytes(c.spill->buffer);
+        }
+    report.add("ExtCells", capacity_bytes(cells) + capacity_bytes(rows));
+    report.add("Spill headers", spills);
+    report.add("Spill runs", runs);
+    report.add("Spill buffers", buffers);
+    report.add("nbrs", nbrs.capacity_bytes());
+    report.add("cell_heap", cell_heap.capacity_bytes());
+    report.add("scratch", capacity_bytes(affected_cells) + capacity_bytes(new_nbrs)
+                        + capacity_bytes(chunk) + capacity_bytes(visited));
+}
+
+template <std::size_t d, typename Scalar, typename Metric, typename Idx>
+void clarkson_external(const std::string& input,
+                       const std::string& output,
+                       std::vector<Idx>& perm,
+                       std::vector<Idx>& pred,
+                       Metric metric,
+                       ExternalConfig config){
+    ExternalNeighborGraph<d, Scalar, Metric, Idx> G(input, output, metric, config);
+
+    std::size_t n = G.size();
+    pred = std::vector<Idx>(n, Idx(-1));
+
+    for(std::size_t i = 1; i < n; i++){
+        pred[i] = static_cast<Idx>(G.heap_top());
+        G.add_cell();
+    }
+#ifdef STAT
+    MemoryReport report;
+    G.memory_usage(report);
+    display_memory(report);
+#endif
+    G.get_rows(perm);
+}
@@ -1,3 +1,6 @@
+#ifndef FAST_SEARCH_H
+#define FAST_SEARCH_H
+
 #include <vector>
 #include <stack>
 #include <cassert>
@@ -5,27 +8,55 @@
 #include "point.hpp"
 #include "metrics.hpp"
 #include "balltree.hpp"
+#include "budget.hpp"
+#include "storage.hpp"
 
 template<size_t d>
 using Point = std::array<double, d>;
 
-template<size_t d>
-using GTNode = std::tuple<Point<d>, double, size_t>;  // center, radius, num_pts
+template<size_t d, typename PtT = Point<d>>
+using GTNode = std::tuple<PtT, double, size_t>;  // center, radius, num_pts
+
+// Idx is the integer type of the aux indices, point counts and search results.
+// With std::uint32_t, indices take half the bytes wherever they are not padded
+// next to a double: search ranges, edges, neighbor lists and pred arrays.
+/**
+ * @brief An entry of a fast_gt layout: a center and the index of its top split in aux.
+ */
+template<typename PtT, typename Idx>
+struct GTEntry {
+    PtT first;
+    Idx second;
+};
 
-template<size_t d>
-using GTPoints = std::vector<std::pair<Point<d>, size_t>>;
+/**
+ * @brief Entry of an aligned row: the coordinates start the entry and the
+ * index sits in the padding after them, so a row of 3 doubles and its index
+ * take one cache line instead of two.
+ */
+template<size_t d, size_t Align, typename Idx>
+struct alignas(Align) GTEntry<AlignedPoint<d, Align>, Idx> {
+    AlignedRow<d, Align> first;
+    Idx second;
+};
 
-using GTData = std::vector<std::pair<double, size_t>>;
+template<size_t d, typename PtT = Point<d>, typename Idx = size_t>
+using GTPoints = std::vector<GTEntry<PtT, Idx>>;
 
-template<size_t d>
-inline Point<d>& center(GTNode<d>& g) { return std::get<0>(g); }
-template<size_t d>
-inline double& node_rad(GTNode<d>& g) { return std::get<1>(g); }
-template<size_t d>
-inline size_t& num_pts(GTNode<d>& g) { return std::get<2>(g); }
+template<typename Idx = size_t>
+using GTDataT = std::vector<std::pair<double, Idx>>;    // radius, num_pts for each split
 
-template<size_t d>
-vector<size_t> children(std::vector<GTNode<d>>& G, size_t node){
+using GTData = GTDataT<>;
+
+template<typename PtT>
+inline PtT& center(std::tuple<PtT, double, size_t>& g) { return std::get<0>(g); }
+template<typename PtT>
+inline double& node_rad(std::tuple<PtT, double, size_t>& g) { return std::get<1>(g); }
+template<typename PtT>
+inline size_t& num_pts(std::tuple<PtT, double, size_t>& g) { return std::get<2>(g); }
+
+template<typename PtT>
+vector<size_t> children(std::vector<std::tuple<PtT, double, size_t>>& G, size_t node){
     vector<size_t> output;
     size_t curr = node+1;
     size_t stop = node + num_pts(G[node]);
@@ -36,16 +67,16 @@ vector<size_t> children(std::vector<GTNode<d>>& G, size_t node){
     return output;
 }
 
-template <size_t d, typename Metric>
-void fast_gt(BallTree<d, Metric>* root, std::vector<GTNode<d>>& output) {
+template <size_t d, typename Metric, typename PtT>
+void fast_gt(BallTree<d, Metric, PtT>* root, std::vector<GTNode<d, PtT>>& output) {
     output.clear();
     if (!root) return;
 
-    std::stack<BallTree<d, Metric>*> to_traverse;
+    std::stack<BallTree<d, Metric, PtT>*> to_traverse;
     to_traverse.push(root);
 
     while (!to_traverse.empty()) {
-        BallTree<d, Metric>* curr = to_traverse.top();
+        BallTree<d, Metric, PtT>* curr = to_traverse.top();
         to_traverse.pop();
 
         // Visit current node
@@ -60,71 +91,224 @@ void fast_gt(BallTree<d, Metric>* root, std::vector<GTNode<d>>& output) {
     }
 }
 
-template <size_t d, typename Metric>
-void fast_gt(BallTree<d, Metric>* root, GTPoints<d>& pts, GTData& aux) {
+template <size_t d, typename Metric, typename PtT, typename Idx>
+void fast_gt(BallTree<d, Metric, PtT>* root, GTPoints<d, PtT, Idx>& pts, GTDataT<Idx>& aux) {
     
     pts.clear();
     aux.clear();
     
     if (!root) return;
 
+    // one entry per node and one filler per left chain: (2n - 1) + n; reserving
+    // it all keeps the arrays from growing after they are advised
     pts.reserve(root->size);
-    aux.reserve(2*root->size-1);
+    aux.reserve(3*root->size-1);
+    advise_huge_pages(pts);
+    advise_huge_pages(aux);
 
-    std::stack<BallTree<d, Metric>*> to_traverse;
+    std::stack<BallTree<d, Metric, PtT>*> to_traverse;
     to_traverse.push(root);
 
     while (!to_traverse.empty()) {
-        BallTree<d, Metric>* curr = to_traverse.top();
+        BallTree<d, Metric, PtT>* curr = to_traverse.top();
         to_traverse.pop();
 
         // Visit current node
-        pts.push_back({*(curr->center), aux.size()});
-        aux.push_back({curr->radius, curr->size});
+        pts.push_back({*(curr->center), static_cast<Idx>(aux.size())});
+        aux.push_back({curr->radius, static_cast<Idx>(curr->size)});
 
         // Follow the left chain directly
         while (curr->left) {
             // Save the right child for later traversal
             to_traverse.push(curr->right.get());
             curr = curr->left.get();
-            aux.push_back({curr->radius, curr->size});
+            aux.push_back({curr->radius, static_cast<Idx>(curr->size)});
         }
         aux.push_back({0, 1});
     }
 }
 
-using Edge = std::tuple<size_t, double, double, size_t, size_t>;    // nbr_index, distance, b_rad, b_pts, aux_index
-using EdgeVec = std::vector<Edge>;
+/**
+ * @brief A subtree of a fast_gt layout: the node whose points start at position i, at split level s.
+ *
+ * The left child shares the center G[i] and the right child starts after the
+ * points of the left child. Leaves have radius 0 and are never split.
+ */
+template<typename Idx = size_t>
+struct GTSubtree {
+    Idx i, s;
+
+    static GTSubtree root() { return {0, 0}; }
+    double rad(const GTDataT<Idx>& aux) const { return aux[s].first; }
+    Idx size(const GTDataT<Idx>& aux) const { return aux[s].second; }
+    GTSubtree left() const { return {i, Idx(s + 1)}; }
+    template<typename PtT>
+    GTSubtree right(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux) const {
+        Idx j = i + aux[s + 1].second;
+        return {j, G[j].second};
+    }
+    bool operator==(const GTSubtree& other) const { return i == other.i && s == other.s; }
+};
+
+// Position of the first point of the node at each split level of a fast_gt layout.
+// fast_gt ends every left chain with an extra (0, 1) entry that is not a node; its
+// start is Idx(-1). A node comes before its descendants in aux, so a reverse
+// scan of aux visits children first.
+template<typename PtT, typename Idx>
+std::vector<Idx> node_starts(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux){
+    std::vector<Idx> start(aux.size(), static_cast<Idx>(-1));
+    for(Idx i = 0; i < G.size(); i++){
+        // the left chain of point i ends at its leaf
+        Idx s = G[i].second;
+        for(; aux[s].second > 1; s++)
+            start[s] = i;
+        start[s] = i;
+    }
+    return start;
+}
+
+// Add the bytes held by a fast_gt layout to report.
+template<typename PtT, typename Idx>
+void memory_usage(const std::vector<GTEntry<PtT, Idx>>& pts, const GTDataT<Idx>& aux, MemoryReport& report){
+    report.add("GTPoints", capacity_bytes(pts));
+    report.add("GTData", capacity_bytes(aux));
+}
+
+template<typename Idx = size_t>
+using EdgeT = std::tuple<Idx, double, double, Idx, Idx>;    // nbr_index, distance, b_rad, b_pts, aux_index
+template<typename Idx = size_t>
+using EdgeVecT = std::vector<EdgeT<Idx>>;
+using Edge = EdgeT<>;
+using EdgeVec = EdgeVecT<>;
 
 struct EdgeComparator{
-    bool operator()(const Edge& u, const Edge& v){
+    template<typename Idx>
+    bool operator()(const EdgeT<Idx>& u, const EdgeT<Idx>& v){
         auto [u_i, u_dist, u_rad, u_pts, u_splits] = u;
         auto [v_i, v_dist, v_rad, v_pts, v_splits] = v;
         return u_rad <= v_rad;
     }
 };
 
-using SearchRange = std::pair<size_t, size_t>;          // nbr_index, num_pts
-using SearchRangeVec = std::vector<SearchRange>;
+// Orders a heap of edges so that the node that may hold the closest point, the
+// one with the smallest distance - radius, is on top.
+struct LowerBoundComparator{
+    template<typename Idx>
+    bool operator()(const EdgeT<Idx>& u, const EdgeT<Idx>& v){
+        auto [u_i, u_dist, u_rad, u_pts, u_splits] = u;
+        auto [v_i, v_dist, v_rad, v_pts, v_splits] = v;
+        return u_dist - u_rad > v_dist - v_rad;
+    }
+};
+
+template<typename Idx = size_t>
+using SearchRangeT = std::pair<Idx, Idx>;          // nbr_index, num_pts
+template<typename Idx = size_t>
+using SearchRangeVecT = std::vector<SearchRangeT<Idx>>;
+using SearchRange = SearchRangeT<>;
+using SearchRangeVec = SearchRangeVecT<>;
+
+/**
+ * @brief Visit each unordered pair of nodes of a fast_gt layout whose points are all within query_rad.
+ *
+ * The pairs are found by a dual-tree walk from (root, root). A node paired with
+ * itself splits into (L, L), (R, R) and (L, R), and a pair of distinct nodes
+ * splits its larger node. within(a) is called when all pairs of points of a are
+ * within query_rad, and across(a, b) when every point of a is within query_rad
+ * of every point of b. Together these calls cover every pair of points within
+ * query_rad exactly once, including each point paired with itself. Pairs of
+ * nodes for which skip(a, b) holds are not visited further.
+ * With e > 0, nodes of radius at most e * query_rad / 4 are taken whole, so the
+ * points may be up to (1 + e) query_rad apart.
+ */
+template<typename PtT, typename Idx, typename Metric, typename Skip, typename Within, typename Across>
+void close_node_pairs(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux,
+                      double query_rad, Metric& metric, double e,
+                      Skip skip, Within within, Across across){
+    if(G.empty())
+        return;
+
+    using Node = GTSubtree<Idx>;
+    // a pair of nodes and the distance between their centers; a == b for the pairs within one node
+    using NodePair = std::tuple<Node, Node, double>;
+    auto rad = [&](Node a){ return a.rad(aux); };
+
+    std::stack<NodePair> to_process;
+    to_process.push({Node::root(), Node::root(), 0});
+    while(!to_process.empty()){
+        auto [a, b, ab_dist] = to_process.top();
+        to_process.pop();
+        if(skip(a, b))
+            continue;
+        double a_rad = rad(a), b_rad = rad(b);
+
+        if(a == b){
+            // every pair within a node is at most twice its radius apart
+            if(2 * a_rad <= query_rad || a_rad <= e * query_rad/4){
+                within(a);
+                continue;
+            }
+            Node l = a.left(), r = a.right(G, aux);
+            double lr_dist = metric.dist_bounded(G[l.i].first, G[r.i].first, query_rad + rad(l) + rad(r));
+            // the pairs within the children come off the stack first
+            to_process.push({l, r, lr_dist});
+            to_process.push({r, r, 0});
+            to_process.push({l, l, 0});
+            continue;
+        }
 
-template<size_t d, typename Metric>
+        if(ab_dist > query_rad + a_rad + b_rad)
+            continue;
+        if(ab_dist <= query_rad - a_rad - b_rad || std::max(a_rad, b_rad) <= e * query_rad/4){
+            across(a, b);
+            continue;
+        }
+        // split the larger node; its left child shares its center, so only the right child costs a distance
+        if(b_rad > a_rad)
+            std::swap(a, b);
+        Node l = a.left(), r = a.right(G, aux);
+        to_process.push({l, b, ab_dist});
+        double rb_dist = metric.dist_bounded(G[r.i].first, G[b.i].first, query_rad + rad(r) + rad(b));
+        to_process.push({r, b, rb_dist});
+    }
+}
+
+template<size_t d, typename Metric, typename PtT = Point<d>, typename Idx = size_t>
 class ApxRngSearch{
-    GTPoints<d>& G;
-    GTData& aux;
+    using EdgeVec = EdgeVecT<Idx>;
+    using SearchRangeVec = SearchRangeVecT<Idx>;
+
+    GTPoints<d, PtT, Idx>& G;
+    GTDataT<Idx>& aux;
     Metric metric;
 
     public:
-    ApxRngSearch(GTPoints<d>& G, GTData& aux, Metric& metric):
+    ApxRngSearch(GTPoints<d, PtT, Idx>& G, GTDataT<Idx>& aux, Metric& metric):
                 G(G), aux(aux), metric(metric){}
 
-    void operator()(Point<d> q, double rad, SearchRangeVec& output, double e=0){
+    void operator()(PtT q, double rad, SearchRangeVec& output, double e=0){
+        (*this)(q, rad, output, SearchBudget(), e);
+    }
+
+    /**
+     * @brief The range search that stops early when the budget runs out.
+     *
+     * The points are settled in the order of G, so output holds every point
+     * in range before the returned position and none after it. At most
+     * G.size() minus that position points in range are missing.
+     */
+    Idx operator()(PtT q, double rad, SearchRangeVec& output, const SearchBudget& budget, double e=0){
         output.clear();
-        size_t i=0, j=0;
+        Idx i=0, j=0;
+        size_t evals = 0;
         while(i < G.size()){
+            if(budget.exhausted(evals++))
+                return i;
             auto& [p, p_aux] = G[i];
             j = p_aux;
-            double p_dist = metric.dist(p, q);
-            size_t curr = i;
+            // the node is pruned at its largest radius unless p is within rad + p_rad
+            double p_dist = metric.dist_bounded(p, q, rad + aux[j].first);
+            Idx curr = i;
             while(curr == i){
                 auto& [p_rad, p_pts] = aux[j];
                 if(p_dist > rad + p_rad)
@@ -137,24 +321,25 @@ class ApxRngSearch{
                     j++;
             }
         }
+        return i;
     }
 
-    void operator()(Point<d> q, double rad, std::vector<size_t>& output, double e=0){
+    void operator()(PtT q, double rad, std::vector<Idx>& output, double e=0){
         output.clear();
         SearchRangeVec ranges;
         (*this)(q, rad, ranges, e);
         for(auto [j, n_j]: ranges)
-            for(size_t k = j; k < j + n_j; k++)
+            for(Idx k = j; k < j + n_j; k++)
                 output.push_back(k);
     }
 
-    void operator()(GTPoints<d>& G_A,
-                    GTData& aux_a,
+    void operator()(GTPoints<d, PtT, Idx>& G_A,
+                    GTDataT<Idx>& aux_a,
                     double query_rad,
                     std::vector<SearchRangeVec>& output,
                     double e=0){
         auto[b_rad, b_pts] = aux[0];
-        using Search = std::tuple<size_t, EdgeVec, SearchRangeVec>;
+        using Search = std::tuple<Idx, EdgeVec, SearchRangeVec>;
         EdgeVec nbrs({{0, 0, b_rad, b_pts, 0}});
         SearchRangeVec absorbed;
         std::stack<Search> to_process;
@@ -166,11 +351,11 @@ class ApxRngSearch{
             to_process.pop();
             auto& [a_ctr, a_aux] = G_A[a_i];
             auto [a_rad, a_pts] = aux_a[a_aux];
-            size_t a_splits = a_aux;
+            Idx a_splits = a_aux;
 
             for(auto& [b_i, b_dist, b_rad, b_pts, b_splits] : nbrs){
                 auto& [b_ctr, b_aux] = G[b_i];
-                b_dist = metric.dist(a_ctr, b_ctr);
+                b_dist = metric.dist_bounded(a_ctr, b_ctr, query_rad + a_rad + b_rad);
             }
                     
             EdgeVec new_nbrs;
@@ -188,10 +373,10 @@ class ApxRngSearch{
                         else{
                             b_splits++;
                             std::tie(b_rad, b_pts) = aux[b_splits];
-                            size_t b_j = b_i+b_pts;
+                            Idx b_j = b_i+b_pts;
                             auto& [b_j_ctr, b_j_splits] = G[b_j];
                             auto& [b_j_rad, b_j_pts] = aux[b_j_splits];
-                            double b_j_dist = metric.dist(a_ctr, b_j_ctr);
+                            double b_j_dist = metric.dist_bounded(a_ctr, b_j_ctr, query_rad + a_rad + b_j_rad);
                             if(b_j_dist <= query_rad + a_rad + b_j_rad)
                                 nbrs.push_back({b_j,
                                             b_j_dist,
@@ -225,108 +410,289 @@ class ApxRngSearch{
         }
     }
 
-    void operator()(GTPoints<d>& G_A,
-                    GTData& aux_a,
+    void operator()(GTPoints<d, PtT, Idx>& G_A,
+                    GTDataT<Idx>& aux_a,
                     double query_rad,
-                    std::vector<std::vector<size_t>>& output,
+                    std::vector<std::vector<Idx>>& output,
                     double e=0){
-        output = std::vector<std::vector<size_t>>(G_A.size());
+        output = std::vector<std::vector<Idx>>(G_A.size());
         std::vector<SearchRangeVec> ranges;
         (*this)(G_A, aux_a, query_rad, ranges, e);
         for(size_t i = 0; i < output.size(); i++){
-            vector<size_t> points;
+            vector<Idx> points;
             for(auto [j, n_j]: ranges[i])
-                for(size_t k = j; k < j + n_j; k++)
+                for(Idx k = j; k < j + n_j; k++)
                     points.push_back(k);
             output[i] = std::move(points);
         }
     }
+
+    /**
+     * @brief Range self-join of the indexed points that visits each unordered pair of nodes once.
+     *
+     * For every two distinct points i and j within query_rad, exactly one of
+     * output[i] and output[j] holds a range containing the other. A pair of
+     * nodes that is absorbed is reported on the side with fewer points. With
+     * include_self, output[i] also holds a range containing i.
+     * e has the same meaning as in the batch search.
+     */
+    void self_join(double query_rad,
+                   std::vector<SearchRangeVec>& output,
+                   double e=0,
+                   bool include_self=false){
+        output = std::vector<SearchRangeVec>(G.size());
+        if(G.empty())
+            return;
+
+        using Node = GTSubtree<Idx>;
+        auto absorb_within = [&](Node a){
+            Idx end = a.i + a.size(aux);
+            for(Idx k = a.i; k < end; k++){
+                Idx first = include_self ? k : k + 1;
+                if(first < end)
+                    output[k].push_back({first, Idx(end - first)});
+            }
+        };
+        auto absorb = [&](Node a, Node b){
+            if(b.size(aux) < a.size(aux))
+                std::swap(a, b);
+            for(Idx k = a.i; k < a.i + a.size(aux); k++)
+                output[k].push_back({b.i, b.size(aux)});
+        };
+        close_node_pairs(G, aux, query_rad, metric, e, [](Node, Node){ return false; }, absorb_within, absorb);
+    }
+
+    void self_join(double query_rad,
+                   std::vector<std::vector<Idx>>& output,
+                   double e=0,
+                   bool include_self=false){
+        std::vector<SearchRangeVec> ranges;
+        self_join(query_rad, ranges, e, include_self);
+        output = std::vector<std::vector<Idx>>(G.size());
+        for(size_t i = 0; i < output.size(); i++)
+            for(auto [j, n_j]: ranges[i])
+                for(Idx k = j; k < j + n_j; k++)
+                    output[i].push_back(k);
+    }
 };
 
-template<size_t d, typename Metric>
+/**
+ * @brief What a query of a stream leaves for the next one: its point, its
+ * answer, and lower bounds on the distances from it to the centers it measured.
+ *
+ * A center c measured at distance r from the previous query q' is at least
+ * r - dist(q, q') from the next query q, so the nodes it rules out are skipped
+ * without measuring c again.
+ */
+template<typename PtT, typename Idx = size_t>
+struct WarmStart {
+    PtT q;
+    Idx nn = 0;
+    // lower bound on the distance from q to each center, by position in G; 0 if not measured
+    std::vector<double> center_dist;
+    std::vector<Idx> measured;
+};
+
+template<size_t d, typename Metric, typename PtT = Point<d>, typename Idx = size_t>
 class ApxNNSearch{
+    using EdgeVec = EdgeVecT<Idx>;
 
-    GTPoints<d>& G;
-    GTData& aux;
+    GTPoints<d, PtT, Idx>& G;
+    GTDataT<Idx>& aux;
     Metric& metric;
 
     EdgeComparator edge_compare;
+    LowerBoundComparator nearer;
 
-    public:
-    ApxNNSearch(GTPoints<d>& G,
-            GTData& aux,
-            Metric& metric):
-            G(G), aux(aux), metric(metric){}
-
-    size_t operator()(Point<d> q, double e=0){
+    // Best-first search over the nodes by lower bound, starting from nn at nn_dist.
+    AnytimeNN<Idx> search_from(PtT q, Idx nn, double nn_dist, const SearchBudget& budget, double e,
+                               WarmStart<PtT, Idx>* warm = nullptr){
         auto& [a, splits] = G[0];
         auto [rad, pts] = aux[splits];
         
-        double nn_dist = metric.dist(a, q);
-        size_t nn = 0;
+        size_t evals = 1;
+        bool complete = true;
+        // distances from q to the centers it measures, for the next query of the stream
+        std::vector<std::pair<Idx, double>> measured;
+        double step = std::numeric_limits<double>::infinity();
+        if(warm && !warm->measured.empty()) {
+            step = metric.dist(q, warm->q);
+            evals++;
+        }
+        // lower bound on the distance from q to G[i] known from the previous query
+        auto prior = [&](Idx i){
+            return step < std::numeric_limits<double>::infinity() ? warm->center_dist[i] - step : 0.0;
+        };
+        if(warm)
+            measured.push_back({nn, nn_dist});
+        // a hint other than the root is the distance the root has to beat
+        double a_dist = nn_dist;
+        if(nn != 0) {
+            a_dist = metric.dist_bounded(q, a, nn_dist + rad);
+            evals++;
+            if(a_dist < nn_dist) {
+                nn_dist = a_dist;
+                nn = 0;
+            }
+            if(warm)
+                measured.push_back({0, a_dist});
+        }
+        // smallest lower bound of the nodes that are not expanded
+        double unexpanded = std::numeric_limits<double>::infinity();
+        // a node is worth expanding while it may hold a point closer than nn_dist / (1 + e)
+        auto viable = [&](double dist, double rad){
+            if((1 + e) * (dist - rad) < nn_dist)
+                return true;
+            unexpanded = std::min(unexpanded, dist - rad);
+            return false;
+        };
         
-        EdgeVec nbrs({{0, nn_dist, rad, pts, splits}});
-        std::make_heap(nbrs.begin(), nbrs.end(), edge_compare);
+        EdgeVec nbrs;
+        if(viable(a_dist, rad))
+            nbrs.push_back({0, a_dist, rad, pts, splits});
         
         while(!nbrs.empty()) {
-            std::pop_heap(nbrs.begin(), nbrs.end(), edge_compare);
+            std::pop_heap(nbrs.begin(), nbrs.end(), nearer);
             auto [a_i, a_dist, a_rad, a_pts, a_splits] = nbrs.back();
             nbrs.pop_back();
             
-            // check pruning condition here
-            if(a_dist < nn_dist + a_rad) {
-                a_splits++;
-                std::tie(a_rad, a_pts) = aux[a_splits];
-                
-                size_t b_i = a_i+a_pts;
-                auto& [b, b_splits] = G[b_i];
-                auto& [b_rad, b_pts] = aux[b_splits];
-                
-                double b_dist = metric.dist(q, b);
+            // every other node is at least as far, so nn is within a factor 1 + e
+            if(!viable(a_dist, a_rad))
+                break;
+            if(budget.exhausted(evals)) {
+                unexpanded = std::min(unexpanded, a_dist - a_rad);
+                complete = false;
+                break;
+            }
+
+            a_splits++;
+            std::tie(a_rad, a_pts) = aux[a_splits];
+            
+            Idx b_i = a_i+a_pts;
+            auto& [b, b_splits] = G[b_i];
+            auto& [b_rad, b_pts] = aux[b_splits];
+            
+            // the right child may be ruled out by the previous query without measuring b
+            double b_dist = prior(b_i);
+            if(viable(b_dist, b_rad)) {
+                // beyond nn_dist + b_rad the right child is pruned and cannot improve nn
+                b_dist = metric.dist_bounded(q, b, nn_dist + b_rad);
+                evals++;
                 if(b_dist < nn_dist) {
                     nn_dist = b_dist;
                     nn = b_i;
                 }
                 
-                nbrs.push_back({b_i, b_dist, b_rad, b_pts, b_splits});
-                std::push_heap(nbrs.begin(), nbrs.end(), edge_compare);
-                
+                if(viable(b_dist, b_rad)) {
+                    nbrs.push_back({b_i, b_dist, b_rad, b_pts, b_splits});
+                    std::push_heap(nbrs.begin(), nbrs.end(), nearer);
+                }
+            }
+            if(warm)
+                measured.push_back({b_i, b_dist});
+            
+            // the left child shares the center of a
+            if(viable(a_dist, a_rad)) {
                 nbrs.push_back({a_i, a_dist, a_rad, a_pts, a_splits});
-                std::push_heap(nbrs.begin(), nbrs.end(), edge_compare);
+                std::push_heap(nbrs.begin(), nbrs.end(), nearer);
+            }
+        }
+        if(warm) {
+            warm->center_dist.resize(G.size());
+            for(Idx i: warm->measured)
+                warm->center_dist[i] = 0;
+            warm->measured.clear();
+            for(auto [i, i_dist]: measured) {
+                warm->center_dist[i] = std::max(warm->center_dist[i], i_dist);
+                warm->measured.push_back(i);
             }
+            warm->q = q;
+            warm->nn = nn;
         }
-        return nn;
+        double lower_bound = std::max(0.0, std::min(nn_dist, unexpanded));
+        return {nn, nn_dist, lower_bound, complete};
     }
 
-    void operator()(GTPoints<d>& G_A,
-                        GTData& aux_a,
-                        std::vector<size_t>& output,
+    public:
+    ApxNNSearch(GTPoints<d, PtT, Idx>& G,
+            GTDataT<Idx>& aux,
+            Metric& metric):
+            G(G), aux(aux), metric(metric){}
+
+    /**
+     * @brief Nearest neighbor of q, or with e > 0 a point at most (1 + e) times as far.
+     *
+     * Nodes are expanded in order of the smallest distance any of their points
+     * could have from q. The search stops once that bound, scaled by 1 + e,
+     * reaches the closest center seen so far.
+     */
+    Idx operator()(PtT q, double e=0){
+        return nearest(q, SearchBudget(), e).nn;
+    }
+
+    /**
+     * @brief The search of operator() that stops early when the budget runs out.
+     *
+     * The lower bound is the smallest bound among the nodes that were not
+     * expanded. When the search completes, the answer is within a factor 1 + e.
+     */
+    AnytimeNN<Idx> nearest(PtT q, const SearchBudget& budget, double e=0){
+        return search_from(q, 0, metric.dist(G[0].first, q), budget, e);
+    }
+
+    /**
+     * @brief Nearest neighbor search that starts from a point believed to be close to q.
+     *
+     * The hint, e.g. the answer to the previous query of a stream of nearby
+     * queries, sets the first distance to beat. Nodes that cannot hold a
+     * point closer than the hint are never expanded. Any hint gives a
+     * correct answer; a good one makes the search cheaper.
+     */
+    AnytimeNN<Idx> nearest(PtT q, Idx hint, const SearchBudget& budget = SearchBudget(), double e=0){
+        return search_from(q, hint, metric.dist(G[hint].first, q), budget, e);
+    }
+
+    /**
+     * @brief Nearest neighbor search for the next query of a stream.
+     *
+     * The search starts from the answer to the previous query and skips the
+     * nodes that the distances measured for it rule out, then leaves its own
+     * state in warm. The answer is the same as without warm; the savings grow
+     * as consecutive queries get closer.
+     */
+    AnytimeNN<Idx> nearest(PtT q, WarmStart<PtT, Idx>& warm, const SearchBudget& budget = SearchBudget(), double e=0){
+        return search_from(q, warm.nn, metric.dist(G[warm.nn].first, q), budget, e, &warm);
+    }
+
+    void operator()(GTPoints<d, PtT, Idx>& G_A,
+                        GTDataT<Idx>& aux_a,
+                        std::vector<Idx>& output,
                         double e=0
                     ){
         auto[b_rad, b_pts] = aux[0];
-        using Search = std::tuple<size_t, EdgeVec>;
+        using Search = std::tuple<Idx, EdgeVec>;
         EdgeVec nbrs({{0, 0, b_rad, b_pts, 0}});
         std::make_heap(nbrs.begin(), nbrs.end(), edge_compare);
 
         std::stack<Search> to_process;
         to_process.push({0, nbrs});
         
-        output = std::vector<size_t>(G_A.size());
+        output = std::vector<Idx>(G_A.size());
         while(!to_process.empty()){
             // pop off the next query node from the stack
             auto [a_i, nbrs] = to_process.top();
             to_process.pop();
             auto& [a_ctr, a_aux] = G_A[a_i];
             auto [a_rad, a_pts] = aux_a[a_aux];
-            size_t a_splits = a_aux;
+            Idx a_splits = a_aux;
 
             // update its nearest nbr and distances to the nbrs
             double nn_dist = std::numeric_limits<double>::max();
-            size_t nn;
+            Idx nn = 0;
 
             for(auto& [b_i, b_dist, b_rad, b_pts, b_splits] : nbrs) {
                 auto& [b_ctr, b_aux] = G[b_i];
-                b_dist = metric.dist(a_ctr, b_ctr);
+                b_dist = metric.dist_bounded(a_ctr, b_ctr, nn_dist + 2*a_rad + b_rad);
                 if(b_dist < nn_dist) {
                     nn_dist = b_dist;
                     nn = b_i;
@@ -350,12 +716,12 @@ class ApxNNSearch{
                         std::tie(b_rad, b_pts) = aux[b_splits];
                         
                         // get the right child
-                        size_t b_j = b_i+b_pts;
+                        Idx b_j = b_i+b_pts;
                         auto& [b_j_ctr, b_j_splits] = G[b_j];
                         auto& [b_j_rad, b_j_pts] = aux[b_j_splits];
                         
                         // update nn_dist with the center of the right child
-                        double new_dist = metric.dist(a_ctr, b_j_ctr);
+                        double new_dist = metric.dist_bounded(a_ctr, b_j_ctr, nn_dist + 2*a_rad + b_j_rad);
                         if(new_dist < nn_dist) {
                             nn_dist = new_dist;
                             nn = b_j;
@@ -390,4 +756,6 @@ class ApxNNSearch{
         // apx_nn_search(0, nbrs, output, e);
     }
 
-};
\ No newline at end of file
+};
+
+#endif // FAST_SEARCH_H
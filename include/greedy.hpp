@@ -13,6 +13,7 @@
 #include "neighborgraph.hpp"
 #include "utils.hpp"
 #include <vector>
+#include <limits>
 
 template <std::size_t d>
 using PtVec = std::vector<std::array<double, d>>;
@@ -21,39 +22,206 @@ template <std::size_t d>
 using PtPtrVec = std::vector<const std::array<double, d>*>;
 
 /**
- * @brief Perform Gonzalez's greedy k-center clustering algorithm.
+ * @brief Read-only view of a contiguous array of points that are not owned.
+ *
+ * @tparam d Dimensionality of the points.
+ */
+template <std::size_t d>
+struct PtView {
+    const std::array<double, d>* data;
+    std::size_t n;
+
+    PtView(const std::array<double, d>* data, std::size_t n): data(data), n(n) {}
+    PtView(const PtVec<d>& pts): data(pts.data()), n(pts.size()) {}
+
+    const std::array<double, d>& operator[](std::size_t i) const { return data[i]; }
+    std::size_t size() const { return n; }
+};
+
+/**
+ * @brief Metric on indices into a PtView, delegating to a point metric.
+ *
+ * Lets NeighborGraph store indices instead of coordinates.
  *
  * @tparam d Dimensionality of the points.
+ * @tparam Metric Metric type for distance calculations on points.
+ */
+template <std::size_t d, typename Metric>
+struct IndexMetric {
+    PtView<d> pts;
+    Metric metric;
+
+    IndexMetric(PtView<d> pts, Metric metric): pts(pts), metric(metric) {}
+
+    double compare_dist(std::size_t a, std::size_t b) const {
+        return metric.compare_dist(pts[a], pts[b]);
+    }
+
+    double dist(std::size_t a, std::size_t b) const {
+        return metric.dist(pts[a], pts[b]);
+    }
+
+    double compare_dist_bounded(std::size_t a, std::size_t b, double limit) const {
+        return metric.compare_dist_bounded(pts[a], pts[b], limit);
+    }
+
+    double dist_bounded(std::size_t a, std::size_t b, double limit) const {
+        return metric.dist_bounded(pts[a], pts[b], limit);
+    }
+
+    double to_compare_dist(double r) const {
+        return metric.to_compare_dist(r);
+    }
+};
+
+/**
+ * @brief Perform Gonzalez's greedy k-center clustering algorithm.
+ *
+ * @tparam PtT Point type, e.g. std::array<double, d> or a BitPoint.
  * @tparam Metric Metric type for distance calculations.
- * @param M Reference to a vector of points to cluster.
- * @param gp Output vector of pointers to selected cluster centers (greedy points).
- * @param pred Output vector of pointers to the predecessor (nearest center) for each point.
+ * @param pts Points to cluster; reordered in place into the greedy permutation.
+ * @param pred Output vector; pred[i] is the position in pts of the predecessor of the ith greedy point (Idx(-1) for the first).
+ * @param radii Output vector; radii[i] is the insertion radius of the ith greedy point (infinity for the first).
  *
  * This function selects cluster centers greedily to maximize the minimum distance
  * between any point and its nearest center.
  */
 // template <std::size_t d, typename Metric>
 // void gonzalez(PtVec<d, Metric>& pts, PtPtrVec<d, Metric>& pred);
-template <std::size_t d, typename Metric>
-void gonzalez(PtVec<d>& pts, vector<size_t>& pred, Metric metric);
+template <typename PtT, typename Metric, typename Idx>
+void gonzalez(std::vector<PtT>& pts, vector<Idx>& pred, vector<double>& radii, Metric metric);
+
+template <typename PtT, typename Metric, typename Idx>
+void gonzalez(std::vector<PtT>& pts, vector<Idx>& pred, Metric metric){
+    vector<double> radii;
+    gonzalez(pts, pred, radii, metric);
+}
 
 /**
- * @brief Perform Clarkson's greedy clustering algorithm.
+ * @brief Non-destructive Gonzalez: leaves the points untouched.
  *
  * @tparam d Dimensionality of the points.
  * @tparam Metric Metric type for distance calculations.
- * @param M Reference to a vector of points to cluster.
- * @param gp Output vector of pointers to selected cluster centers (greedy points).
- * @param pred Output vector of pointers to the predecessor (nearest center) for each point.
+ * @param pts View of the points to cluster.
+ * @param perm Output vector; perm[i] is the index in pts of the ith greedy point.
+ * @param pred Output vector; pred[i] is the position in perm of the predecessor of the ith greedy point.
+ * @param radii Output vector; radii[i] is the insertion radius of the ith greedy point (infinity for the first).
+ */
+template <std::size_t d, typename Metric, typename Idx>
+void gonzalez(PtView<d> pts, vector<Idx>& perm, vector<Idx>& pred, vector<double>& radii, Metric metric);
+
+template <std::size_t d, typename Metric, typename Idx>
+void gonzalez(const PtVec<d>& pts, vector<Idx>& perm, vector<Idx>& pred, vector<double>& radii, Metric metric){
+    gonzalez(PtView<d>(pts), perm, pred, radii, metric);
+}
+
+/**
+ * @brief Perform Clarkson's greedy clustering algorithm.
+ *
+ * @tparam PtT Point type, e.g. std::array<double, d> or a BitPoint.
+ * @tparam Metric Metric type for distance calculations.
+ * @param pts Points to cluster; reordered in place into the greedy permutation.
+ * @param pred Output vector; pred[i] is the position in pts of the predecessor of the ith greedy point (Idx(-1) for the first).
+ * @param radii Output vector; radii[i] is the insertion radius of the ith greedy point (infinity for the first).
+ * @param heap Empty cell heap; CellHeap gives the exact greedy order.
  *
  * This function implements Clarkson's variant of greedy clustering for metric spaces.
  */
 // template <std::size_t d, typename Metric>
 // void clarkson(PtVec<d, Metric>& pts, PtPtrVec<d, Metric>& pred);
-template <std::size_t d, typename Metric>
-void clarkson(PtVec<d>& pts, vector<size_t>& pred, Metric metric);
+template <typename PtT, typename Metric, typename Idx, typename Heap>
+void clarkson(std::vector<PtT>& pts, vector<Idx>& pred, vector<double>& radii, Metric metric, Heap heap);
+
+template <typename PtT, typename Metric, typename Idx>
+void clarkson(std::vector<PtT>& pts, vector<Idx>& pred, vector<double>& radii, Metric metric){
+    clarkson(pts, pred, radii, metric, CellHeap());
+}
+
+template <typename PtT, typename Metric, typename Idx, typename Heap>
+void clarkson(std::vector<PtT>& pts, vector<Idx>& pred, Metric metric, Heap heap){
+    vector<double> radii;
+    clarkson(pts, pred, radii, metric, std::move(heap));
+}
+
+template <typename PtT, typename Metric, typename Idx>
+void clarkson(std::vector<PtT>& pts, vector<Idx>& pred, Metric metric){
+    clarkson(pts, pred, metric, CellHeap());
+}
+
+/**
+ * @brief Relaxed Clarkson: each point is taken from a cell whose radius is
+ * within a (1+eps) factor of the largest, using a RadiusBucketQueue.
+ *
+ * The output is a (1+eps)-approximate greedy permutation and pred is as in clarkson().
+ */
+template <typename PtT, typename Metric, typename Idx>
+void clarkson(std::vector<PtT>& pts, vector<Idx>& pred, Metric metric, double eps){
+    clarkson(pts, pred, metric, RadiusBucketQueue(eps));
+}
+
+/**
+ * @brief Non-destructive Clarkson: cells hold indices into pts, never coordinates.
+ *
+ * @tparam d Dimensionality of the points.
+ * @tparam Metric Metric type for distance calculations.
+ * @param pts View of the points to cluster.
+ * @param perm Output vector; perm[i] is the index in pts of the ith greedy point.
+ * @param pred Output vector; pred[i] is the position in perm of the predecessor of the ith greedy point.
+ * @param radii Output vector; radii[i] is the insertion radius of the ith greedy point (infinity for the first).
+ */
+template <std::size_t d, typename Metric, typename Idx>
+void clarkson(PtView<d> pts, vector<Idx>& perm, vector<Idx>& pred, vector<double>& radii, Metric metric);
+
+template <std::size_t d, typename Metric, typename Idx>
+void clarkson(const PtVec<d>& pts, vector<Idx>& perm, vector<Idx>& pred, vector<double>& radii, Metric metric){
+    clarkson(PtView<d>(pts), perm, pred, radii, metric);
+}
+
+/**
+ * @brief Length of the shortest greedy prefix that is within r of every point.
+ *
+ * In an exact greedy permutation radii[k] is the largest distance from a
+ * remaining point to the first k points, so the prefix covers all points within
+ * r and its points are more than r apart: it is an r-net. In a (1+eps)-approximate
+ * permutation, as built by clarkson() with a RadiusBucketQueue, radii[k] is only
+ * within a factor (1+eps) of that distance, so the prefix covers within (1+eps)r
+ * and its points are more than r/(1+eps) apart. Takes O(n - k) time.
+ *
+ * @param radii Insertion radii of a greedy permutation.
+ */
+inline size_t greedy_prefix(const vector<double>& radii, double r);
+
+/**
+ * @brief Radius within which the first k greedy points cover all points: the
+ * insertion radius of the next point, or 0 if k covers every point.
+ *
+ * Exact for an exact greedy permutation; for a (1+eps)-approximate one the
+ * points are covered within (1+eps) times this radius.
+ */
+inline double prefix_radius(const vector<double>& radii, size_t k);
+
+/**
+ * @brief Label every point by its ancestor among the first k points of the greedy permutation.
+ *
+ * labels[i] is i for i < k and labels[pred[i]] otherwise, so all labels are
+ * found in one pass since pred[i] < i. The clusters are nested: the cut at k
+ * refines the cut at any smaller k, and one build answers every k. A k of 0
+ * is taken as 1, since the first point has no predecessor to be labeled by.
+ *
+ * @param pred Predecessors from clarkson() or gonzalez().
+ */
+template <typename Idx>
+void greedy_cut(const vector<Idx>& pred, size_t k, vector<Idx>& labels);
+
+/**
+ * @brief Cut at the shortest prefix that is within r of every point.
+ * @return The number of clusters.
+ */
+template <typename Idx>
+size_t greedy_cut(const vector<Idx>& pred, const vector<double>& radii, double r, vector<Idx>& labels);
 
 #include "greedy_gonzalez_impl.hpp"
 #include "greedy_clarkson_impl.hpp"
+#include "greedy_cut_impl.hpp"
 
 #endif
\ No newline at end of file
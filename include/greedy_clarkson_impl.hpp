@@ -1,49 +1,79 @@
-template <std::size_t d, typename Metric>
-void clarkson(PtVec<d>& pts, vector<size_t>& pred, Metric metric){
-    using CellT = Cell<d, Metric>;
-    using Pt = std::array<double, d>;
+template <typename PtT, typename Metric, typename Idx, typename Heap>
+void clarkson(std::vector<PtT>& pts, vector<Idx>& pred, vector<double>& radii, Metric metric, Heap heap){
+    constexpr std::size_t d = point_dim<PtT>::value;
+    using CellT = Cell<d, Metric, PtT, CellAllocator<PtT>>;
 
     size_t n = pts.size();
     size_t num_cells_exist = CellT::next_id;
 
-    // initialize pred
-    pred = vector<size_t>(n, -1);
+    // initialize pred and the insertion radii
+    pred = vector<Idx>(n, Idx(-1));
+    radii = vector<double>(n, std::numeric_limits<double>::infinity());
 
     if (pts.empty())
         return;
 
-    // create neighbor graph
-    NeighborGraph<d, Metric> G(pts, metric);
+    // create neighbor graph; large cells, the root above all, are put on huge
+    // pages as storage_policy() asks
+    NeighborGraph<d, Metric, PtT, Heap, Idx, CellAllocator<PtT>> G(pts, metric, std::move(heap));
 
     debug_log("Center of root is at " << G.cells[0].center);
     
-#ifdef STAT
-    stat_log("i, mean, std_dev, 25, 50, 75, max");
-#endif
-    for(auto i = 1; i < n; i++){
+    for(size_t i = 1; i < n; i++){
         // get the index of the cell at the top of the cell heap
         size_t cell_i = G.heap_top();
         // set it to be the parent of the ith pt in the permutation
         pred[i] = cell_i;
+        // the radius of the top cell is the distance to the point about to be inserted
+        radii[i] = G.cells[cell_i].radius;
         // add the next cell to the neighbor graph
         G.add_cell();
 #ifdef STAT
-        vector<size_t> nbrs(G.cells.size(), -1);
-        for(auto j = 0; j < G.cells.size(); j++){
-            nbrs[j] = G.cells[j].nbrs.size();
-        }
-        auto [mean, std] = mean_std_dev(nbrs);
-        std::sort(nbrs.begin(), nbrs.end());
-        stat_log(i<<','<<mean<<','<< std <<','<<nbrs[i/4]<<','<<nbrs[i/2]<<','<<nbrs[3*i/4]<<','<<nbrs.back());
+        // sample the degrees each time the number of cells doubles, O(n) in total
+        if((i & (i + 1)) == 0)
+            build_stats().sample_degrees(G.cells.size(), [&G](size_t j){ return G.nbrs.degree(j); });
 #endif
     }
+#ifdef STAT
+    MemoryReport report;
+    G.memory_usage(report);
+    display_memory(report);
+#endif
     // extract the greedy permutation from the neighbor graph
     G.get_permutation(true, pts);
 
     debug_log("Number of cells created: " << CellT::next_id - num_cells_exist);
+    debug_log("Distance evaluations skipped in rebalance: " << G.num_skipped_evals());
+    debug_log("Donor cells skipped in point location: " << G.num_skipped_cells());
 
 #ifdef STAT
-    display_malloc_usage();
-    display_phys_footprint();
+    build_stats().sample_degrees(G.cells.size(), [&G](size_t j){ return G.nbrs.degree(j); });
 #endif
-}
\ No newline at end of file
+}
+
+template <std::size_t d, typename Metric, typename Idx>
+void clarkson(PtView<d> pts, vector<Idx>& perm, vector<Idx>& pred, vector<double>& radii, Metric metric){
+    using IdxMetric = IndexMetric<d, Metric>;
+
+    size_t n = pts.size();
+    pred = vector<Idx>(n, Idx(-1));
+    radii = vector<double>(n, std::numeric_limits<double>::infinity());
+    perm.clear();
+
+    if (n == 0)
+        return;
+
+    // the cells of the neighbor graph hold indices into pts
+    vector<Idx> idx(n);
+    std::iota(idx.begin(), idx.end(), 0);
+    NeighborGraph<d, IdxMetric, Idx, CellHeap, Idx, CellAllocator<Idx>> G(idx, IdxMetric(pts, metric));
+
+    for(size_t i = 1; i < n; i++){
+        size_t cell_i = G.heap_top();
+        pred[i] = cell_i;
+        // the radius of the top cell is the distance to the point about to be inserted
+        radii[i] = G.cells[cell_i].radius;
+        G.add_cell();
+    }
+    G.get_permutation(true, perm);
+}
@@ -0,0 +1,28 @@
+inline size_t greedy_prefix(const vector<double>& radii, double r){
+    size_t k = radii.size();
+    // the first point is always in the prefix
+    while(k > 1 && radii[k - 1] <= r)
+        k--;
+    return k;
+}
+
+inline double prefix_radius(const vector<double>& radii, size_t k){
+    return k < radii.size() ? radii[k] : 0;
+}
+
+template <typename Idx>
+void greedy_cut(const vector<Idx>& pred, size_t k, vector<Idx>& labels){
+    size_t n = pred.size();
+    // the first point has no predecessor, so it always starts a cluster
+    k = std::max<size_t>(k, 1);
+    labels.resize(n);
+    for(size_t i = 0; i < n; i++)
+        labels[i] = i < k ? static_cast<Idx>(i) : labels[pred[i]];
+}
+
+template <typename Idx>
+size_t greedy_cut(const vector<Idx>& pred, const vector<double>& radii, double r, vector<Idx>& labels){
+    size_t k = greedy_prefix(radii, r);
+    greedy_cut(pred, k, labels);
+    return k;
+}
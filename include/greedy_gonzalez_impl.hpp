@@ -1,9 +1,8 @@
-template <std::size_t d, typename Metric>
-void gonzalez(PtVec<d>& pts, vector<size_t>& pred, Metric metric){
+template <typename PtT, typename Metric, typename Idx>
+void gonzalez(std::vector<PtT>& pts, vector<Idx>& pred, vector<double>& radii, Metric metric){
 
-    using Pt = std::array<double, d>;
-
-    pred = vector<size_t>(pts.size(), -1);
+    pred = vector<Idx>(pts.size(), Idx(-1));
+    radii = vector<double>(pts.size(), std::numeric_limits<double>::infinity());
     std::vector<double> pred_dist(pts.size());
 
     if (pts.empty())
@@ -25,6 +24,7 @@ void gonzalez(PtVec<d>& pts, vector<size_t>& pred, Metric metric){
         std::swap(pts[i], pts[far_i]);
         std::swap(pred[i], pred[far_i]);
         std::swap(pred_dist[i], pred_dist[far_i]);
+        radii[i] = metric.dist(pts[pred[i]], pts[i]);
         
         // c. for each uninserted point, check if it is closer than current pred
         for(auto j = i+1; j < pts.size(); j++){
@@ -36,3 +36,48 @@ void gonzalez(PtVec<d>& pts, vector<size_t>& pred, Metric metric){
         }
     }
 }
+
+
+template <std::size_t d, typename Metric, typename Idx>
+void gonzalez(PtView<d> pts, vector<Idx>& perm, vector<Idx>& pred, vector<double>& radii, Metric metric){
+
+    size_t n = pts.size();
+    perm = vector<Idx>(n);
+    pred = vector<Idx>(n, Idx(-1));
+    radii = vector<double>(n, std::numeric_limits<double>::infinity());
+    std::vector<double> pred_dist(n);
+
+    if (n == 0)
+        return;
+
+    std::iota(perm.begin(), perm.end(), 0);
+
+    // initialize the first cell
+    for(size_t i = 1; i < n; i++){
+        pred[i] = 0;
+        pred_dist[i] = metric.compare_dist(pts[0], pts[i]);
+    }
+
+    // in each iteration
+    for(size_t i = 1; i < n; i++){
+        // a. find the farthest point from its pred
+        auto max_dist = std::max_element(pred_dist.begin()+i, pred_dist.end());
+        size_t far_i = std::distance(pred_dist.begin(), max_dist);
+
+        // b. Update the output, permuting indices instead of points
+        std::swap(perm[i], perm[far_i]);
+        std::swap(pred[i], pred[far_i]);
+        std::swap(pred_dist[i], pred_dist[far_i]);
+        radii[i] = metric.dist(pts[perm[pred[i]]], pts[perm[i]]);
+
+        // c. for each uninserted point, check if it is closer than current pred
+        const auto& p_i = pts[perm[i]];
+        for(size_t j = i+1; j < n; j++){
+            double curr_dist = metric.compare_dist(p_i, pts[perm[j]]);
+            if(pred_dist[j] > curr_dist){
+                pred[j] = i;
+                pred_dist[j] = curr_dist;
+            }
+        }
+    }
+}
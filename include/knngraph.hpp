@@ -0,0 +1,66 @@
+/**
+ * @file knngraph.hpp
+ * @author Siddarth Sheth
+ * @brief Approximate k-nearest-neighbor graphs extracted from Clarkson's neighbor graph.
+ *
+ * When Clarkson's algorithm finishes, every point is a cell center and the
+ * neighbor lists link each center to centers that were close at the scale of
+ * its cell. Together with the edges from each point to its predecessor, these
+ * lists seed a k-NN list per point, which is then refined by a few passes in
+ * which every point looks at the neighbors of its neighbors, as in NN-descent.
+ * The result costs a small multiple of the greedy permutation instead of a
+ * separate all-k-NN computation.
+ */
+
+#ifndef KNNGRAPH_H
+#define KNNGRAPH_H
+
+#include "greedy.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Directed k-NN graph in compressed sparse row form.
+ *
+ * The neighbors of point i are ids[offsets[i]], ..., ids[offsets[i+1]-1], sorted
+ * by increasing distance, and dists holds the matching distances. A point is
+ * never its own neighbor.
+ *
+ * @tparam Idx Integer type of the point ids.
+ */
+template <typename Idx = std::uint32_t>
+struct KnnGraph {
+    std::vector<std::size_t> offsets;
+    std::vector<Idx> ids;
+    std::vector<double> dists;
+
+    std::size_t num_points() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::size_t degree(std::size_t i) const { return offsets[i + 1] - offsets[i]; }
+};
+
+/**
+ * @brief Clarkson's algorithm that also returns an approximate k-NN graph.
+ *
+ * pts and pred are as in clarkson(); the ids of knn are positions in the
+ * permuted pts.
+ *
+ * @param k Number of neighbors per point (fewer if there are at most k points).
+ * @param passes Maximum number of neighbor-of-neighbor passes; they stop early
+ *        once a pass changes no list.
+ */
+template <typename PtT, typename Metric, typename Idx>
+void clarkson_knn(std::vector<PtT>& pts, vector<Idx>& pred, KnnGraph<Idx>& knn,
+                  std::size_t k, Metric metric, std::size_t passes = 3);
+
+/**
+ * @brief Non-destructive variant; perm and pred are as in the non-destructive
+ * clarkson(), and the rows and ids of knn are indices into pts.
+ */
+template <std::size_t d, typename Metric, typename Idx>
+void clarkson_knn(PtView<d> pts, vector<Idx>& perm, vector<Idx>& pred, KnnGraph<Idx>& knn,
+                  std::size_t k, Metric metric, std::size_t passes = 3);
+
+#include "knngraph_impl.hpp"
+
+#endif // KNNGRAPH_H
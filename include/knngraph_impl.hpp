@@ -0,0 +1,235 @@
+/**
+ * @brief Bounded k-NN lists of n points, kept sorted by distance in one flat array.
+ */
+template <typename Idx>
+class KnnLists {
+public:
+    KnnLists(size_t n, size_t k): n(n), k(k), entries(n * k), sizes(n, 0) {}
+
+    size_t size() const { return n; }
+    size_t size(size_t i) const { return sizes[i]; }
+    size_t max_size() const { return k; }
+    Idx id(size_t i, size_t a) const { return entries[i * k + a].id; }
+    double dist(size_t i, size_t a) const { return entries[i * k + a].dist; }
+
+    /**
+     * @brief Add j at distance dist to the list of i unless it is already there or too far.
+     * @return True if the list of i changed.
+     */
+    bool insert(size_t i, size_t j, double dist){
+        if(k == 0)
+            return false;
+        Entry* l = &entries[i * k];
+        size_t s = sizes[i];
+        if(s == k && dist >= l[s - 1].dist)
+            return false;
+        for(size_t a = 0; a < s; a++)
+            if(l[a].id == j)
+                return false;
+        // a full list drops its last entry
+        size_t pos = s < k ? s : k - 1;
+        while(pos > 0 && l[pos - 1].dist > dist){
+            l[pos] = l[pos - 1];
+            pos--;
+        }
+        l[pos] = Entry({dist, static_cast<Idx>(j)});
+        if(s < k)
+            sizes[i]++;
+        return true;
+    }
+
+    /**
+     * @brief Write the lists to knn; with a label, list i becomes row label[i] and ids j become label[j].
+     */
+    void to_csr(KnnGraph<Idx>& knn, const vector<Idx>* label = nullptr) const {
+        auto row = [&](size_t i){ return label ? size_t((*label)[i]) : i; };
+        knn.offsets.assign(n + 1, 0);
+        for(size_t i = 0; i < n; i++)
+            knn.offsets[row(i) + 1] = sizes[i];
+        std::partial_sum(knn.offsets.begin(), knn.offsets.end(), knn.offsets.begin());
+        knn.ids.resize(knn.offsets[n]);
+        knn.dists.resize(knn.offsets[n]);
+        for(size_t i = 0; i < n; i++){
+            size_t out = knn.offsets[row(i)];
+            for(size_t a = 0; a < sizes[i]; a++){
+                const Entry& e = entries[i * k + a];
+                knn.ids[out + a] = label ? (*label)[e.id] : e.id;
+                knn.dists[out + a] = e.dist;
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        double dist;
+        Idx id;
+    };
+
+    size_t n;
+    size_t k;
+    std::vector<Entry> entries;
+    std::vector<size_t> sizes;
+};
+
+/**
+ * @brief Seed the lists with the edges of the final neighbor graph and of the greedy tree.
+ *
+ * Every undirected edge is evaluated once and offered to both of its ends.
+ */
+template <typename Idx, typename Nbrs, typename PredIdx, typename Dist>
+void seed_knn(KnnLists<Idx>& lists, const Nbrs& nbrs, const vector<PredIdx>& pred, Dist dist){
+    for(size_t i = 0; i < lists.size(); i++){
+        for(size_t j: nbrs[i]){
+            if(j <= i)
+                continue;
+            double d_ij = dist(i, j);
+            lists.insert(i, j, d_ij);
+            lists.insert(j, i, d_ij);
+        }
+        if(i > 0){
+            double d_ip = dist(i, pred[i]);
+            lists.insert(i, pred[i], d_ip);
+            lists.insert(pred[i], i, d_ip);
+        }
+    }
+}
+
+/**
+ * @brief Neighbor-of-neighbor passes over the lists and their reverse.
+ *
+ * In every pass each point i offers itself to, and is offered, every point l
+ * that is a neighbor or reverse neighbor of one of its own neighbors or
+ * reverse neighbors. Marks ensure that i evaluates each l at most once per
+ * pass, though the pair may be evaluated again from l. A hub can be on the
+ * lists of many points, so, as NN-descent samples rho * k of them, the reverse
+ * list of a point keeps only the 2k points that list it closest, and a pass
+ * costs O(n k^2) evaluations.
+ */
+template <typename Idx, typename Dist>
+void refine_knn(KnnLists<Idx>& lists, Dist dist, size_t passes){
+    size_t n = lists.size();
+    constexpr size_t unmarked = static_cast<size_t>(-1);
+    std::vector<size_t> mark(n, unmarked);
+    size_t rev_cap = std::max<size_t>(2 * lists.max_size(), 1);
+    std::vector<size_t> rev_offsets(n + 1);
+    std::vector<std::pair<double, Idx>> rev_all;
+    std::vector<Idx> rev;
+    std::vector<size_t> hop;
+
+    for(size_t pass = 0; pass < passes; pass++){
+        // reverse lists, as of the start of the pass
+        std::fill(rev_offsets.begin(), rev_offsets.end(), 0);
+        for(size_t i = 0; i < n; i++)
+            for(size_t a = 0; a < lists.size(i); a++)
+                rev_offsets[lists.id(i, a) + 1]++;
+        std::partial_sum(rev_offsets.begin(), rev_offsets.end(), rev_offsets.begin());
+        rev_all.resize(rev_offsets[n]);
+        {
+            std::vector<size_t> fill(rev_offsets.begin(), rev_offsets.end() - 1);
+            for(size_t i = 0; i < n; i++)
+                for(size_t a = 0; a < lists.size(i); a++)
+                    rev_all[fill[lists.id(i, a)]++] = {lists.dist(i, a), static_cast<Idx>(i)};
+        }
+        // keep the rev_cap closest reverse neighbors of each point
+        rev.clear();
+        for(size_t j = 0; j < n; j++){
+            auto first = rev_all.begin() + rev_offsets[j];
+            auto last = rev_all.begin() + rev_offsets[j + 1];
+            if(size_t(last - first) > rev_cap){
+                std::nth_element(first, first + rev_cap, last);
+                last = first + rev_cap;
+            }
+            rev_offsets[j] = rev.size();
+            for(auto it = first; it != last; it++)
+                rev.push_back(it->second);
+        }
+        rev_offsets[n] = rev.size();
+
+        size_t updates = 0;
+        for(size_t i = 0; i < n; i++){
+            mark[i] = i;
+            hop.clear();
+            for(size_t a = 0; a < lists.size(i); a++){
+                hop.push_back(lists.id(i, a));
+                mark[lists.id(i, a)] = i;
+            }
+            for(size_t r = rev_offsets[i]; r < rev_offsets[i + 1]; r++)
+                hop.push_back(rev[r]);
+
+            auto offer = [&](size_t l){
+                if(mark[l] == i)
+                    return;
+                mark[l] = i;
+                double d_il = dist(i, l);
+                updates += lists.insert(i, l, d_il);
+                updates += lists.insert(l, i, d_il);
+            };
+            for(size_t j: hop){
+                for(size_t a = 0; a < lists.size(j); a++)
+                    offer(lists.id(j, a));
+                for(size_t r = rev_offsets[j]; r < rev_offsets[j + 1]; r++)
+                    offer(rev[r]);
+            }
+        }
+        debug_log("refine_knn: pass " << pass << " changed " << updates << " entries");
+        if(updates == 0)
+            break;
+    }
+}
+
+template <typename PtT, typename Metric, typename Idx>
+void clarkson_knn(std::vector<PtT>& pts, vector<Idx>& pred, KnnGraph<Idx>& knn,
+                  std::size_t k, Metric metric, std::size_t passes){
+    constexpr std::size_t d = point_dim<PtT>::value;
+
+    size_t n = pts.size();
+    pred = vector<Idx>(n, Idx(-1));
+    knn = KnnGraph<Idx>();
+    knn.offsets.assign(1, 0);
+    if(n == 0)
+        return;
+
+    NeighborGraph<d, Metric, PtT, CellHeap, Idx, CellAllocator<PtT>> G(pts, metric);
+    for(size_t i = 1; i < n; i++){
+        pred[i] = G.heap_top();
+        G.add_cell();
+    }
+    // the centers are moved out, but the neighbor lists stay valid
+    G.get_permutation(true, pts);
+
+    auto dist = [&](size_t a, size_t b){ return metric.dist(pts[a], pts[b]); };
+    KnnLists<Idx> lists(n, std::min(k, n - 1));
+    seed_knn(lists, G.nbrs, pred, dist);
+    refine_knn(lists, dist, passes);
+    lists.to_csr(knn);
+}
+
+template <std::size_t d, typename Metric, typename Idx>
+void clarkson_knn(PtView<d> pts, vector<Idx>& perm, vector<Idx>& pred, KnnGraph<Idx>& knn,
+                  std::size_t k, Metric metric, std::size_t passes){
+    using IdxMetric = IndexMetric<d, Metric>;
+
+    size_t n = pts.size();
+    pred = vector<Idx>(n, Idx(-1));
+    perm.clear();
+    knn = KnnGraph<Idx>();
+    knn.offsets.assign(1, 0);
+    if(n == 0)
+        return;
+
+    vector<Idx> idx(n);
+    std::iota(idx.begin(), idx.end(), 0);
+    NeighborGraph<d, IdxMetric, Idx, CellHeap, Idx, CellAllocator<Idx>> G(idx, IdxMetric(pts, metric));
+    for(size_t i = 1; i < n; i++){
+        pred[i] = G.heap_top();
+        G.add_cell();
+    }
+    G.get_permutation(true, perm);
+
+    // the lists are built over positions in the permutation and relabeled on output
+    auto dist = [&](size_t a, size_t b){ return metric.dist(pts[perm[a]], pts[perm[b]]); };
+    KnnLists<Idx> lists(n, std::min(k, n - 1));
+    seed_knn(lists, G.nbrs, pred, dist);
+    refine_knn(lists, dist, passes);
+    lists.to_csr(knn, &perm);
+}
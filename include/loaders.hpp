@@ -0,0 +1,121 @@
+/**
+ * @file loaders.hpp
+ * @author Siddarth Sheth
+ * @brief Memory-mapped readers for the standard ANN benchmark file formats.
+ *
+ * Supported formats, chosen by file extension:
+ * - fvecs, ivecs, bvecs: every row is an int32 dimension followed by that many
+ *   float32, int32 or uint8 values (the TEXMEX format of SIFT1M and GIST1M).
+ * - fbin, ibin, u8bin: a header of two uint32, the number of rows and the
+ *   dimension, followed by the rows of float32, int32 or uint8 values (the
+ *   big-ann-benchmarks format). Trailing data, e.g. the distances in a
+ *   ground-truth file, is ignored.
+ *
+ * Files are mapped read-only and rows are converted straight from the mapping
+ * into the point type used by greedy_tree and fast_gt. Every function throws
+ * std::runtime_error if a file cannot be opened or mapped, or if its contents
+ * do not match its format.
+ */
+
+#ifndef LOADERS_H
+#define LOADERS_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * @brief Read-only memory map of a whole file.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return addr; }
+    std::size_t size() const { return bytes; }
+    const std::string& path() const { return file_path; }
+
+private:
+    std::string file_path;
+    const unsigned char* addr;
+    std::size_t bytes;
+};
+
+enum class VecsFormat { fvecs, ivecs, bvecs, fbin, ibin, u8bin };
+
+/**
+ * @brief Format of a file, from its extension.
+ */
+inline VecsFormat vecs_format(const std::string& path);
+
+/**
+ * @brief A mapped file of n rows of dim values of type T.
+ *
+ * T must be the value type of the format: float for fvecs and fbin,
+ * std::int32_t for ivecs and ibin, std::uint8_t for bvecs and u8bin.
+ */
+template <typename T>
+class VecsFile {
+public:
+    explicit VecsFile(const std::string& path);
+
+    std::size_t size() const { return n; }
+    std::size_t dim() const { return d; }
+
+    /**
+     * @brief Pointer to the dim values of row i, inside the mapping.
+     */
+    const T* operator[](std::size_t i) const {
+        return reinterpret_cast<const T*>(file.data() + offset + i * stride);
+    }
+
+private:
+    MappedFile file;
+    std::size_t n;
+    std::size_t d;
+    std::size_t offset;     // bytes before the first value of row 0
+    std::size_t stride;     // bytes between consecutive rows
+};
+
+/**
+ * @brief Dimension of the rows of a file in any supported format.
+ */
+inline std::size_t vecs_dim(const std::string& path);
+
+/**
+ * @brief Number of rows of a file in any supported format.
+ */
+inline std::size_t vecs_size(const std::string& path);
+
+/**
+ * @brief Load the first max_n rows of a float or byte file as points.
+ *
+ * @tparam d Dimensionality of the points; must equal the dimension of the file.
+ * @param path Path of an fvecs, bvecs, fbin or u8bin file.
+ * @param max_n Maximum number of rows to load.
+ */
+template <std::size_t d>
+std::vector<std::array<double, d>> load_points(const std::string& path,
+                                               std::size_t max_n = std::numeric_limits<std::size_t>::max());
+
+/**
+ * @brief Load the first k neighbor ids of the first max_n rows of a ground-truth file.
+ *
+ * @param path Path of an ivecs or ibin file.
+ * @param k Maximum number of ids per row.
+ * @param max_n Maximum number of rows to load.
+ */
+inline std::vector<std::vector<std::uint32_t>> load_neighbors(const std::string& path,
+                                                              std::size_t k = std::numeric_limits<std::size_t>::max(),
+                                                              std::size_t max_n = std::numeric_limits<std::size_t>::max());
+
+#include "loaders_impl.hpp"
+
+#endif // LOADERS_H
@@ -0,0 +1,194 @@
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+inline MappedFile::MappedFile(const std::string& path):
+                                file_path(path),
+                                addr(nullptr),
+                                bytes(0){
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    struct stat st;
+    if(::fstat(fd, &st) != 0){
+        ::close(fd);
+        throw std::runtime_error("MappedFile: cannot stat " + path);
+    }
+    bytes = st.st_size;
+    if(bytes > 0){
+        void* p = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED){
+            ::close(fd);
+            throw std::runtime_error("MappedFile: cannot map " + path);
+        }
+        // rows are converted front to back
+        ::madvise(p, bytes, MADV_SEQUENTIAL);
+        addr = static_cast<const unsigned char*>(p);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+inline MappedFile::~MappedFile(){
+    if(addr)
+        ::munmap(const_cast<unsigned char*>(addr), bytes);
+}
+
+inline VecsFormat vecs_format(const std::string& path){
+    std::string ext = path.substr(path.find_last_of('.') + 1);
+    if(ext == "fvecs") return VecsFormat::fvecs;
+    if(ext == "ivecs") return VecsFormat::ivecs;
+    if(ext == "bvecs") return VecsFormat::bvecs;
+    if(ext == "fbin") return VecsFormat::fbin;
+    if(ext == "ibin") return VecsFormat::ibin;
+    if(ext == "u8bin") return VecsFormat::u8bin;
+    throw std::runtime_error("vecs_format: unknown extension of " + path);
+}
+
+/**
+ * @brief Value type of each format, for the checks in VecsFile.
+ */
+template <typename T>
+inline bool holds_values_of(VecsFormat format){
+    switch(format){
+        case VecsFormat::fvecs:
+        case VecsFormat::fbin:
+            return std::is_same_v<T, float>;
+        case VecsFormat::ivecs:
+        case VecsFormat::ibin:
+            return std::is_same_v<T, std::int32_t>;
+        case VecsFormat::bvecs:
+        case VecsFormat::u8bin:
+            return std::is_same_v<T, std::uint8_t>;
+    }
+    return false;
+}
+
+template <typename T>
+VecsFile<T>::VecsFile(const std::string& path):
+                        file(path),
+                        n(0),
+                        d(0),
+                        offset(0),
+                        stride(0){
+    VecsFormat format = vecs_format(path);
+    if(!holds_values_of<T>(format))
+        throw std::runtime_error("VecsFile: wrong value type for " + path);
+
+    bool vecs = format == VecsFormat::fvecs || format == VecsFormat::ivecs || format == VecsFormat::bvecs;
+    if(vecs){
+        // TEXMEX: every row repeats its dimension
+        if(file.size() == 0)
+            return;
+        std::int32_t dim;
+        if(file.size() < sizeof(dim))
+            throw std::runtime_error("VecsFile: truncated header in " + path);
+        std::memcpy(&dim, file.data(), sizeof(dim));
+        if(dim <= 0)
+            throw std::runtime_error("VecsFile: invalid dimension in " + path);
+        d = dim;
+        offset = sizeof(dim);
+        stride = sizeof(dim) + d * sizeof(T);
+        if(file.size() % stride != 0)
+            throw std::runtime_error("VecsFile: size of " + path + " is not a multiple of the row size");
+        n = file.size() / stride;
+        // spot check the last row, a cheap guard against mixed dimensions
+        std::memcpy(&dim, file.data() + (n - 1) * stride, sizeof(dim));
+        if(std::size_t(dim) != d)
+            throw std::runtime_error("VecsFile: rows of different dimensions in " + path);
+    }
+    else{
+        std::uint32_t header[2];
+        if(file.size() < sizeof(header))
+            throw std::runtime_error("VecsFile: truncated header in " + path);
+        std::memcpy(header, file.data(), sizeof(header));
+        n = header[0];
+        d = header[1];
+        offset = sizeof(header);
+        stride = d * sizeof(T);
+        if(file.size() < offset + n * stride)
+            throw std::runtime_error("VecsFile: " + path + " is shorter than its header says");
+    }
+}
+
+inline std::size_t vecs_dim(const std::string& path){
+    switch(vecs_format(path)){
+        case VecsFormat::fvecs:
+        case VecsFormat::fbin:
+            return VecsFile<float>(path).dim();
+        case VecsFormat::ivecs:
+        case VecsFormat::ibin:
+            return VecsFile<std::int32_t>(path).dim();
+        case VecsFormat::bvecs:
+        case VecsFormat::u8bin:
+            return VecsFile<std::uint8_t>(path).dim();
+    }
+    return 0;
+}
+
+inline std::size_t vecs_size(const std::string& path){
+    switch(vecs_format(path)){
+        case VecsFormat::fvecs:
+        case VecsFormat::fbin:
+            return VecsFile<float>(path).size();
+        case VecsFormat::ivecs:
+        case VecsFormat::ibin:
+            return VecsFile<std::int32_t>(path).size();
+        case VecsFormat::bvecs:
+        case VecsFormat::u8bin:
+            return VecsFile<std::uint8_t>(path).size();
+    }
+    return 0;
+}
+
+template <std::size_t d, typename T>
+std::vector<std::array<double, d>> convert_rows(const VecsFile<T>& file, const std::string& path, std::size_t max_n){
+    if(file.dim() != d)
+        throw std::runtime_error("load_points: " + path + " has dimension " + std::to_string(file.dim())
+                                 + ", expected " + std::to_string(d));
+    std::size_t n = std::min(max_n, file.size());
+    std::vector<std::array<double, d>> pts(n);
+    for(std::size_t i = 0; i < n; i++){
+        const T* row = file[i];
+        for(std::size_t k = 0; k < d; k++)
+            pts[i][k] = row[k];
+    }
+    return pts;
+}
+
+template <std::size_t d>
+std::vector<std::array<double, d>> load_points(const std::string& path, std::size_t max_n){
+    switch(vecs_format(path)){
+        case VecsFormat::fvecs:
+        case VecsFormat::fbin:
+            return convert_rows<d>(VecsFile<float>(path), path, max_n);
+        case VecsFormat::bvecs:
+        case VecsFormat::u8bin:
+            return convert_rows<d>(VecsFile<std::uint8_t>(path), path, max_n);
+        default:
+            throw std::runtime_error("load_points: " + path + " does not hold points");
+    }
+}
+
+inline std::vector<std::vector<std::uint32_t>> load_neighbors(const std::string& path, std::size_t k, std::size_t max_n){
+    VecsFormat format = vecs_format(path);
+    if(format != VecsFormat::ivecs && format != VecsFormat::ibin)
+        throw std::runtime_error("load_neighbors: " + path + " does not hold neighbor ids");
+    VecsFile<std::int32_t> file(path);
+    std::size_t n = std::min(max_n, file.size());
+    k = std::min(k, file.dim());
+    std::vector<std::vector<std::uint32_t>> ids(n, std::vector<std::uint32_t>(k));
+    for(std::size_t i = 0; i < n; i++){
+        const std::int32_t* row = file[i];
+        for(std::size_t j = 0; j < k; j++){
+            if(row[j] < 0)
+                throw std::runtime_error("load_neighbors: negative id in " + path);
+            ids[i][j] = row[j];
+        }
+    }
+    return ids;
+}
@@ -3,17 +3,64 @@
  * @author Siddarth Sheth
  * @brief Metric structures for norm and distance calculations in d-dimensional space.
  *
- * Provides L2 (Euclidean) and L1 (Manhattan) metrics for use with Point classes.
+ * Provides L2 (Euclidean) and L1 (Manhattan) metrics for use with Point classes,
+ * a Hamming metric for packed binary codes and an angular metric for points
+ * with cached norms.
  */
 
 #ifndef METRICS_H
 #define METRICS_H
 
 #include <cmath>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 // Forward declaration of Point class template.
 // template <std::size_t d, typename Metric> class Point;
 
+// Forward declaration of the point type with a cached norm (see point.hpp).
+template <std::size_t d> struct NormedPoint;
+
+// Forward declaration of the rows known to start on an Align-byte boundary (see storage.hpp).
+template <std::size_t d, std::size_t Align> struct AlignedRow;
+
+/**
+ * @brief Tell the compiler that p is aligned to Align bytes, so that the loops
+ * over it vectorize with aligned loads and without a peeled prologue.
+ */
+template <std::size_t Align>
+inline const double* assume_aligned(const double* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<const double*>(__builtin_assume_aligned(p, Align));
+#else
+    return p;
+#endif
+}
+
+/**
+ * @brief Number of coordinates summed between checks against the limit in the
+ * bounded distance functions.
+ *
+ * Every metric provides compare_dist_bounded(a, b, limit) and dist_bounded(a, b, limit).
+ * They return the same value as compare_dist and dist whenever that value is at
+ * most limit; otherwise they may stop early and return any value greater than limit.
+ */
+inline constexpr std::size_t bound_check_block = 16;
+
+// Every metric also provides to_compare_dist(r), the monotone map from a
+// distance r to the scale of compare_dist, so that bounds derived from the
+// triangle inequality can be tested against stored compare_dist values.
+
 /**
  * @brief L2 (Euclidean) metric for norm and distance calculations.
  *
@@ -28,12 +75,15 @@ struct L2Metric {
      */
     template <std::size_t d>
     static double compare_dist(const std::array<double, d>& a, const std::array<double, d>& b) {
-        double sum = 0.0;
-        for (std::size_t i = 0; i < d; ++i) {
-            double diff = a[i] - b[i];
-            sum += diff * diff;
-        }
-        return sum;
+        return sum_sq<d, alignof(double)>(a.data(), b.data());
+    }
+
+    /**
+     * @brief compare_dist of two rows on Align-byte boundaries, with aligned loads.
+     */
+    template <std::size_t d, std::size_t Align>
+    static double compare_dist(const AlignedRow<d, Align>& a, const AlignedRow<d, Align>& b) {
+        return sum_sq<d, Align>(a.data(), b.data());
     }
 
     /**
@@ -45,12 +95,95 @@ struct L2Metric {
      */
     template <std::size_t d>
     static double dist(const std::array<double, d>& a, const std::array<double, d>& b) {
+        return std::sqrt(compare_dist(a, b));
+    }
+
+    template <std::size_t d, std::size_t Align>
+    static double dist(const AlignedRow<d, Align>& a, const AlignedRow<d, Align>& b) {
+        return std::sqrt(compare_dist(a, b));
+    }
+
+    /**
+     * @brief compare_dist that stops once the running sum exceeds limit.
+     * @tparam d Dimensionality of the points.
+     * @param a The first point.
+     * @param b The second point.
+     * @param limit Bound on the squared distance.
+     * @return The squared distance, or a partial sum greater than limit.
+     */
+    template <std::size_t d>
+    static double compare_dist_bounded(const std::array<double, d>& a, const std::array<double, d>& b, double limit) {
+        return sum_sq_bounded<d, alignof(double)>(a.data(), b.data(), limit);
+    }
+
+    template <std::size_t d, std::size_t Align>
+    static double compare_dist_bounded(const AlignedRow<d, Align>& a, const AlignedRow<d, Align>& b, double limit) {
+        return sum_sq_bounded<d, Align>(a.data(), b.data(), limit);
+    }
+
+    /**
+     * @brief dist that stops once the distance is known to exceed limit.
+     * @tparam d Dimensionality of the points.
+     * @param a The first point.
+     * @param b The second point.
+     * @param limit Bound on the distance.
+     * @return The L2 distance, or a value greater than limit.
+     */
+    template <std::size_t d>
+    static double dist_bounded(const std::array<double, d>& a, const std::array<double, d>& b, double limit) {
+        if (limit < 0)
+            return dist(a, b);
+        return std::sqrt(compare_dist_bounded(a, b, limit * limit));
+    }
+
+    template <std::size_t d, std::size_t Align>
+    static double dist_bounded(const AlignedRow<d, Align>& a, const AlignedRow<d, Align>& b, double limit) {
+        if (limit < 0)
+            return dist(a, b);
+        return std::sqrt(compare_dist_bounded(a, b, limit * limit));
+    }
+
+    /**
+     * @brief Convert a distance to the scale of compare_dist.
+     * @param r A distance.
+     * @return r squared.
+     */
+    static double to_compare_dist(double r) {
+        return r * r;
+    }
+
+private:
+    template <std::size_t d, std::size_t Align>
+    static double sum_sq(const double* a, const double* b) {
+        a = assume_aligned<Align>(a);
+        b = assume_aligned<Align>(b);
         double sum = 0.0;
         for (std::size_t i = 0; i < d; ++i) {
             double diff = a[i] - b[i];
             sum += diff * diff;
         }
-        return std::sqrt(sum);
+        return sum;
+    }
+
+    template <std::size_t d, std::size_t Align>
+    static double sum_sq_bounded(const double* a, const double* b, double limit) {
+        a = assume_aligned<Align>(a);
+        b = assume_aligned<Align>(b);
+        double sum = 0.0;
+        std::size_t i = 0;
+        for (; i + bound_check_block <= d; i += bound_check_block) {
+            for (std::size_t k = i; k < i + bound_check_block; ++k) {
+                double diff = a[k] - b[k];
+                sum += diff * diff;
+            }
+            if (sum > limit)
+                return sum;
+        }
+        for (; i < d; ++i) {
+            double diff = a[i] - b[i];
+            sum += diff * diff;
+        }
+        return sum;
     }
 };
 
@@ -68,10 +201,15 @@ struct L1Metric {
      */
     template <std::size_t d>
     static double compare_dist(const std::array<double, d>& a, const std::array<double, d>& b) {
-        double sum = 0.0;
-        for (std::size_t i = 0; i < d; ++i)
-            sum += std::abs(a[i] - b[i]);
-        return sum;
+        return sum_abs<d, alignof(double)>(a.data(), b.data());
+    }
+
+    /**
+     * @brief compare_dist of two rows on Align-byte boundaries, with aligned loads.
+     */
+    template <std::size_t d, std::size_t Align>
+    static double compare_dist(const AlignedRow<d, Align>& a, const AlignedRow<d, Align>& b) {
+        return sum_abs<d, Align>(a.data(), b.data());
     }
 
     /**
@@ -83,11 +221,303 @@ struct L1Metric {
      */
     template <std::size_t d>
     static double dist(const std::array<double, d>& a, const std::array<double, d>& b) {
+        return compare_dist(a, b);
+    }
+
+    template <std::size_t d, std::size_t Align>
+    static double dist(const AlignedRow<d, Align>& a, const AlignedRow<d, Align>& b) {
+        return compare_dist(a, b);
+    }
+
+    /**
+     * @brief compare_dist that stops once the running sum exceeds limit.
+     * @tparam d Dimensionality of the points.
+     * @param a The first point.
+     * @param b The second point.
+     * @param limit Bound on the distance.
+     * @return The L1 distance, or a partial sum greater than limit.
+     */
+    template <std::size_t d>
+    static double compare_dist_bounded(const std::array<double, d>& a, const std::array<double, d>& b, double limit) {
+        return sum_abs_bounded<d, alignof(double)>(a.data(), b.data(), limit);
+    }
+
+    template <std::size_t d, std::size_t Align>
+    static double compare_dist_bounded(const AlignedRow<d, Align>& a, const AlignedRow<d, Align>& b, double limit) {
+        return sum_abs_bounded<d, Align>(a.data(), b.data(), limit);
+    }
+
+    /**
+     * @brief dist that stops once the running sum exceeds limit.
+     */
+    template <std::size_t d>
+    static double dist_bounded(const std::array<double, d>& a, const std::array<double, d>& b, double limit) {
+        return compare_dist_bounded(a, b, limit);
+    }
+
+    template <std::size_t d, std::size_t Align>
+    static double dist_bounded(const AlignedRow<d, Align>& a, const AlignedRow<d, Align>& b, double limit) {
+        return compare_dist_bounded(a, b, limit);
+    }
+
+    /**
+     * @brief Convert a distance to the scale of compare_dist, which is the identity.
+     */
+    static double to_compare_dist(double r) {
+        return r;
+    }
+
+private:
+    template <std::size_t d, std::size_t Align>
+    static double sum_abs(const double* a, const double* b) {
+        a = assume_aligned<Align>(a);
+        b = assume_aligned<Align>(b);
         double sum = 0.0;
         for (std::size_t i = 0; i < d; ++i)
             sum += std::abs(a[i] - b[i]);
         return sum;
     }
+
+    template <std::size_t d, std::size_t Align>
+    static double sum_abs_bounded(const double* a, const double* b, double limit) {
+        a = assume_aligned<Align>(a);
+        b = assume_aligned<Align>(b);
+        double sum = 0.0;
+        std::size_t i = 0;
+        for (; i + bound_check_block <= d; i += bound_check_block) {
+            for (std::size_t k = i; k < i + bound_check_block; ++k)
+                sum += std::abs(a[k] - b[k]);
+            if (sum > limit)
+                return sum;
+        }
+        for (; i < d; ++i)
+            sum += std::abs(a[i] - b[i]);
+        return sum;
+    }
+};
+
+/**
+ * @brief Hamming metric on packed binary codes (see BitPoint).
+ *
+ * The distance is the number of differing bits, computed with hardware popcount.
+ * Codes whose word count is a multiple of the vector width use AVX-512
+ * VPOPCNTDQ, AVX2 or NEON when the target is compiled with support for them.
+ * On x86-64 the scalar popcount is a single instruction only with -mpopcnt or
+ * a -march that includes it (the CMake option GREEDY_NATIVE adds -march=native);
+ * otherwise the compiler calls a software routine.
+ */
+struct HammingMetric {
+    /**
+     * @brief Popcount of a 64-bit word.
+     */
+    static inline int popcount(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        int count = 0;
+        for (; x; x &= x - 1)
+            ++count;
+        return count;
+#endif
+    }
+
+    /**
+     * @brief Number of bits in which two codes differ.
+     * @tparam w Number of 64-bit words in a code.
+     * @param a The first code.
+     * @param b The second code.
+     * @return The Hamming distance between a and b.
+     */
+    template <std::size_t w>
+    static double compare_dist(const std::array<std::uint64_t, w>& a, const std::array<std::uint64_t, w>& b) {
+        std::size_t i = 0;
+        std::uint64_t sum = 0;
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+        if constexpr (w >= 8) {
+            __m512i acc = _mm512_setzero_si512();
+            for (; i + 8 <= w; i += 8) {
+                __m512i x = _mm512_xor_si512(_mm512_loadu_si512(a.data() + i),
+                                             _mm512_loadu_si512(b.data() + i));
+                acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(x));
+            }
+            sum += _mm512_reduce_add_epi64(acc);
+        }
+#elif defined(__AVX2__)
+        if constexpr (w >= 4) {
+            // nibble lookup table popcount, summed per 64-bit lane with sad
+            const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low_mask = _mm256_set1_epi8(0x0f);
+            __m256i acc = _mm256_setzero_si256();
+            for (; i + 4 <= w; i += 4) {
+                __m256i x = _mm256_xor_si256(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.data() + i)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data() + i)));
+                __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, low_mask));
+                __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+            }
+            sum += _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+                 + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+        }
+#elif defined(__ARM_NEON)
+        if constexpr (w >= 2) {
+            uint64x2_t acc = vdupq_n_u64(0);
+            for (; i + 2 <= w; i += 2) {
+                uint8x16_t x = veorq_u8(vreinterpretq_u8_u64(vld1q_u64(a.data() + i)),
+                                        vreinterpretq_u8_u64(vld1q_u64(b.data() + i)));
+                acc = vaddq_u64(acc, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vcntq_u8(x)))));
+            }
+            sum += vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+        }
+#endif
+        for (; i < w; ++i)
+            sum += popcount(a[i] ^ b[i]);
+        return static_cast<double>(sum);
+    }
+
+    /**
+     * @brief Hamming distance between two codes; identical to compare_dist.
+     * @tparam w Number of 64-bit words in a code.
+     * @param a The first code.
+     * @param b The second code.
+     * @return The Hamming distance between a and b.
+     */
+    template <std::size_t w>
+    static double dist(const std::array<std::uint64_t, w>& a, const std::array<std::uint64_t, w>& b) {
+        return compare_dist(a, b);
+    }
+
+    /**
+     * @brief compare_dist that stops once the running count exceeds limit.
+     * @tparam w Number of 64-bit words in a code.
+     * @param a The first code.
+     * @param b The second code.
+     * @param limit Bound on the Hamming distance.
+     * @return The Hamming distance, or a partial count greater than limit.
+     *
+     * The count is checked after every 128 bits, so this path uses the scalar
+     * popcount; a far code is rejected after reading only a prefix of it.
+     */
+    template <std::size_t w>
+    static double compare_dist_bounded(const std::array<std::uint64_t, w>& a, const std::array<std::uint64_t, w>& b, double limit) {
+        std::size_t i = 0;
+        std::uint64_t sum = 0;
+        for (; i + 2 <= w; i += 2) {
+            sum += popcount(a[i] ^ b[i]) + popcount(a[i + 1] ^ b[i + 1]);
+            if (sum > limit)
+                return static_cast<double>(sum);
+        }
+        if (i < w)
+            sum += popcount(a[i] ^ b[i]);
+        return static_cast<double>(sum);
+    }
+
+    /**
+     * @brief dist that stops once the distance is known to exceed limit; identical to compare_dist_bounded.
+     */
+    template <std::size_t w>
+    static double dist_bounded(const std::array<std::uint64_t, w>& a, const std::array<std::uint64_t, w>& b, double limit) {
+        if (limit < 0)
+            return dist(a, b);
+        return compare_dist_bounded(a, b, limit);
+    }
+
+    /**
+     * @brief Convert a distance to the scale of compare_dist, which is the identity.
+     */
+    static double to_compare_dist(double r) {
+        return r;
+    }
+};
+
+/**
+ * @brief Angular metric: the angle between two vectors, in radians.
+ *
+ * Operates on NormedPoint, whose norm is computed once on construction, so
+ * each evaluation is a single dot product, plus a pass over the unit vectors
+ * for angles small enough that acos would lose digits. Unlike the cosine
+ * distance 1 - cos, the angle satisfies the triangle inequality, which the
+ * pruning rules of the trees and searches rely on. A zero vector is at angle pi/2 from every other vector.
+ */
+struct AngularMetric {
+    /**
+     * @brief Cosine of the angle between two points.
+     * @tparam d Dimensionality of the points.
+     */
+    template <std::size_t d>
+    static double cosine(const NormedPoint<d>& a, const NormedPoint<d>& b) {
+        if (a.norm == 0 || b.norm == 0)
+            return (a.norm == b.norm) ? 1.0 : 0.0;
+        double dot = 0.0;
+        for (std::size_t i = 0; i < d; ++i)
+            dot += a.coords[i] * b.coords[i];
+        return std::max(-1.0, std::min(1.0, dot / (a.norm * b.norm)));
+    }
+
+    /**
+     * @brief Cosine distance 1 - cos, which orders pairs the same way as dist.
+     * @tparam d Dimensionality of the points.
+     * @param a The first point.
+     * @param b The second point.
+     * @return The cosine distance between a and b.
+     */
+    template <std::size_t d>
+    static double compare_dist(const NormedPoint<d>& a, const NormedPoint<d>& b) {
+        return 1.0 - cosine(a, b);
+    }
+
+    /**
+     * @brief Compute the angle between two points.
+     * @tparam d Dimensionality of the points.
+     * @param a The first point.
+     * @param b The second point.
+     * @return The angle between a and b in [0, pi].
+     */
+    template <std::size_t d>
+    static double dist(const NormedPoint<d>& a, const NormedPoint<d>& b) {
+        double c = cosine(a, b);
+        if (c < small_angle_cos || a.norm == 0 || b.norm == 0)
+            return std::acos(c);
+        // acos is ill-conditioned near 1, so small angles are taken from the
+        // chord between the unit vectors, which keeps full relative precision
+        double chord = 0.0;
+        for (std::size_t i = 0; i < d; ++i) {
+            double diff = a.coords[i] / a.norm - b.coords[i] / b.norm;
+            chord += diff * diff;
+        }
+        return 2.0 * std::asin(std::min(1.0, std::sqrt(chord) / 2.0));
+    }
+
+    /**
+     * @brief Bounded variants; a partial dot product bounds nothing, so the full value is returned.
+     */
+    template <std::size_t d>
+    static double compare_dist_bounded(const NormedPoint<d>& a, const NormedPoint<d>& b, double) {
+        return compare_dist(a, b);
+    }
+
+    template <std::size_t d>
+    static double dist_bounded(const NormedPoint<d>& a, const NormedPoint<d>& b, double) {
+        return dist(a, b);
+    }
+
+    /**
+     * @brief Convert an angle to the scale of compare_dist, i.e. 1 - cos(r).
+     *
+     * Angles beyond [0, pi] are clamped first; a bound of 2r or 3r computed by
+     * the pruning rules would otherwise wrap around and shrink.
+     */
+    static double to_compare_dist(double r) {
+        const double pi = std::acos(-1.0);
+        return 1.0 - std::cos(std::max(0.0, std::min(pi, r)));
+    }
+
+private:
+    /**
+     * @brief Cosine above which dist switches from acos to the chord, about 0.45 radians.
+     */
+    static constexpr double small_angle_cos = 0.9;
 };
 
 #endif // METRICS_H
\ No newline at end of file
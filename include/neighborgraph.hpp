@@ -12,35 +12,53 @@
 #define NEIGHBORGRAPH_H
 
 #include "cell.hpp"
-#include <queue>
+#include "cellheap.hpp"
+#include "adjacency.hpp"
+#include "utils.hpp"
+#include "storage.hpp"
 #include <vector>
 #include <algorithm>
 #include <numeric>
 #include <iterator>
-#include <boost/unordered/unordered_flat_set.hpp>
+#include <cstdint>
+#include <stdexcept>
 
 /**
  * @brief Graph of cells for neighbor relationships in metric space.
  *
  * @tparam d Dimensionality of the space.
  * @tparam Metric Metric type for distance calculations.
+ * @tparam PtT Point type stored in the cells. Defaults to coordinates; an index
+ *         type together with an IndexMetric builds the graph without copying points.
+ * @tparam Heap Priority queue of cell indices by radius. CellHeap gives the exact
+ *         greedy order; RadiusBucketQueue gives a (1+eps)-approximate one.
+ * @tparam Idx Integer type of the cell ids in the neighbor lists.
+ * @tparam Alloc Allocator of the points held by the cells. With anything but
+ *         std::allocator the root cell copies the input points, which are
+ *         released once the copy is made.
  *
  * Adjacency list to represent undirected connectivity between cells.
  */
-template<size_t d, typename Metric>
+template<size_t d, typename Metric, typename PtT = std::array<double, d>, typename Heap = CellHeap, typename Idx = std::uint32_t,
+         typename Alloc = std::allocator<PtT>>
 class NeighborGraph {
 private:
     /**
      * @brief Point type in d-dimensional space.
      */
-    using Pt = std::array<double, d>;
+    using Pt = PtT;
+    using CellT = Cell<d, Metric, PtT, Alloc>;
     /**
      * @brief Reference to a Cell.
      */
-    using CellRef = Cell<d,Metric>&;
+    using CellRef = CellT&;
     
 public:
-    std::vector<Cell<d,Metric>> cells;
+    std::vector<CellT> cells;
+    /**
+     * @brief Neighbor list of each cell, indexed like cells. Every cell is its own neighbor.
+     */
+    ChunkedAdjacency<Idx> nbrs;
     
     /**
      * @brief Get the top cell from the heap.
@@ -51,8 +69,11 @@ public:
     /**
      * @brief Construct a NeighborGraph from a vector of points.
      * @param P Vector of points to initialize the graph.
+     * @param heap Empty cell heap, e.g. a RadiusBucketQueue configured with eps.
+     *
+     * Throws std::length_error if the cells cannot be numbered by Idx.
      */
-    NeighborGraph(std::vector<Pt>& pts, Metric metric);
+    NeighborGraph(std::vector<Pt>& pts, Metric metric, Heap heap = Heap());
     
     /**
      * @brief Add a new cell to the graph.
@@ -60,20 +81,39 @@ public:
     void add_cell();
     
     void get_permutation(bool move, std::vector<Pt>& output);
-    
-private:
+
+    /**
+     * @brief Number of point distances rebalance skipped using the triangle inequality.
+     */
+    size_t num_skipped_evals() const { return skipped_evals; }
+
     /**
-     * @brief Pair of unique_ptr to Cell and a double (for heap operations).
+     * @brief Number of donor cells point location skipped because no point could move.
      */
-    using HeapPair = std::pair<size_t, double>;
+    size_t num_skipped_cells() const { return skipped_cells; }
+
+    /**
+     * @brief Add the bytes held by the cells, neighbor lists, cell heap and scratch buffers to report.
+     */
+    void memory_usage(MemoryReport& report) const;
+    
+private:
     Metric metric;
     
     std::vector<size_t> affected_cells;
+    std::vector<size_t> new_nbrs;
     std::vector<double> a_distances;
     std::vector<Pt> move_pts, keep_pts;
     std::vector<double> move_dists, keep_dists;
     std::vector<size_t> move_idx, keep_idx;
     bool centers_moved;
+    size_t skipped_evals;
+    size_t skipped_cells;
+    /**
+     * @brief visited[i] == epoch iff cell i was already seen by the current nbr_nbr_update.
+     */
+    std::vector<std::uint32_t> visited;
+    std::uint32_t epoch;
     
     /**
      * @brief Add an edge between two cells in the graph.
@@ -81,34 +121,33 @@ private:
      * @param j Index of second cell in cells.
      */
     inline void add_edge(size_t i, size_t j){
-        cells[i].nbrs.push_back(j);
-        cells[j].nbrs.push_back(i);
+        stats_count(edges_added, 2);
+        nbrs.push_back(i, j);
+        nbrs.push_back(j, i);
     }
 
     /**
-     * @brief Comparator for heap operations on HeapPair.
+     * @brief Cells keyed by radius, updated in place whenever a radius shrinks.
      */
-    struct CellCompare {
-        /**
-         * @brief Compare two HeapPairs for heap ordering.
-         * @param a First HeapPair.
-         * @param b Second HeapPair.
-         * @return True if a < b for heap purposes.
-         */
-        bool operator()(const HeapPair& a, const HeapPair& b)const;
-    };
+    Heap cell_heap;
 
     /**
-     * @brief Vector of HeapPairs for heap-based operations.
+     * @brief Key of cell i in the cell heap: its radius, or -1 once it has no points.
+     *
+     * A cell whose remaining points all coincide with its center has radius 0
+     * too, and must be taken before the empty cells.
      */
-    std::priority_queue<HeapPair, std::vector<HeapPair>, CellCompare> cell_heap;
+    inline double heap_key(size_t i) const {
+        return cells[i].size() ? cells[i].radius : -1;
+    }
     
     /**
-     * @brief Rebalance the graph after cell changes.
-     * @param a Pointer to first cell.
-     * @param b Pointer to second cell.
+     * @brief Move the points of cell j that are closer to the center of cell i.
+     * @param i Index of the new cell in cells.
+     * @param j Index of the donor cell in cells.
+     * @param ctr_dist Distance between the centers of the two cells.
      */
-    void rebalance(size_t i, size_t j);
+    void rebalance(size_t i, size_t j, double ctr_dist);
     /**
      * @brief Check if two cells are close enough (according to some metric).
      * @param i Index of first cell in cells.
@@ -120,7 +159,10 @@ private:
         double j_r = cells[j].radius;
         double min_r = min(i_r, j_r);
         double max_r = max(i_r, j_r);
-        return min_r > 0 && metric.dist(cells[i].center, cells[j].center) <= i_r + j_r + max_r;
+        if(min_r <= 0)
+            return false;
+        stats_count(dist_evals, 1);
+        return metric.dist(cells[i].center, cells[j].center) <= i_r + j_r + max_r;
         // return min_r > 0 && cells[i].dist(cells[j]) <= i_r + j_r + max_r;
         // return cells[i].dist(cells[j]) <= i_r + j_r + max_r;
     }
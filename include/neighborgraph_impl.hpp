@@ -1,18 +1,31 @@
-template <std::size_t d, typename Metric>
-NeighborGraph<d, Metric>::NeighborGraph(vector<Pt>& pts,
-                                        Metric metric):
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::NeighborGraph(vector<Pt>& pts,
+                                        Metric metric,
+                                        Heap heap):
+                                        metric(metric),
                                         centers_moved(false),
-                                        metric(metric){
+                                        skipped_evals(0),
+                                        skipped_cells(0),
+                                        epoch(0),
+                                        cell_heap(std::move(heap)){
 
-    // reserve space for vector of cells
-    cells.reserve(pts.size());
+    // checked once here, so that the neighbor lists can store ids unchecked
+    if(!pts.empty() && pts.size() - 1 > ChunkedAdjacency<Idx>::max_id)
+        throw std::length_error("NeighborGraph: too many points for the index type");
+
+    // reserve space for vector of cells, on huge pages if it is large
+    cells.reserve(pts.size() + 1);
+    advise_huge_pages(cells);
+    nbrs.reserve(pts.size() + 1);
+    visited.reserve(pts.size() + 1);
 
     // extract seed point from input vector
     std::swap(pts.front(), pts.back());
     Pt root_pt = std::move(pts.back());
     pts.pop_back();
 
-    std::vector<double> distances;
+    decltype(CellT::distances) distances;
+    distances.reserve(pts.size());
     std::transform(pts.begin(), pts.end(),
                     std::back_inserter(distances),
                     [&root_pt, &metric](const Pt& pt){
@@ -20,27 +33,35 @@ NeighborGraph<d, Metric>::NeighborGraph(vector<Pt>& pts,
                     });
     
     // initialize root cell
-    cells.push_back(Cell(std::move(root_pt), metric));
+    cells.push_back(CellT(std::move(root_pt), metric));
     CellRef root = cells[0];
 
     // point location for root cell
-    root.points = std::move(pts);
+    if constexpr (std::is_same_v<Alloc, std::allocator<Pt>>)
+        root.points = std::move(pts);
+    else {
+        // cell storage has its own allocator, so the points are copied into it
+        root.points.assign(std::make_move_iterator(pts.begin()), std::make_move_iterator(pts.end()));
+        std::vector<Pt>().swap(pts);
+    }
     root.distances = std::move(distances);
 
     // radius update for root cell
     root.update_radius();
 
     // initialize the neighbor graph
-    root.nbrs.push_back(0);
+    nbrs.add_vertex();
+    nbrs.push_back(0, 0);
+    visited.push_back(0);
     
     // initialize the cell heap with the root cell
-    cell_heap.push(HeapPair({0, root.radius}));
+    cell_heap.push(0, heap_key(0));
 
     debug_log("NeighborGraph: Root cell created.");
 }
 
-template <std::size_t d, typename Metric>
-void NeighborGraph<d, Metric>::add_cell(){
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+void NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::add_cell(){
     if(centers_moved){
         debug_log("add_cell: Cells do not exist");
         return;
@@ -56,11 +77,11 @@ void NeighborGraph<d, Metric>::add_cell(){
     prune_edges();
     // add the new cell to the cell heap
     debug_log("add_cell: Adding cell " << cells[cell_i].center << " to heap with radius " << cells[cell_i].radius);
-    cell_heap.push(HeapPair({cell_i, cells[cell_i].radius}));
+    cell_heap.push(cell_i, heap_key(cell_i));
 }
 
-template <std::size_t d, typename Metric>
-void NeighborGraph<d, Metric>::rebalance(size_t i, size_t j){
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+void NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::rebalance(size_t i, size_t j, double ctr_dist){
     debug_log("rebalance: PL on " << cells[j].points.size() << " points from " << cells[j].center << " to " << cells[i].center);
     
     CellRef a = cells[i];
@@ -81,8 +102,23 @@ void NeighborGraph<d, Metric>::rebalance(size_t i, size_t j){
     //                 std::back_inserter(a_distances),
     //                 [&a_center](const Pt& pt){ return a_center.compare_dist(pt); });
     // a_distances.reserve(b.points.size());
-    for(Pt& pt:b.points)
-        a_distances.push_back(metric.compare_dist(a_center, pt));
+    // a point within half the center distance of b is at least as close to b as to a,
+    // so it stays without evaluating its distance to a
+    double stay_dist = metric.to_compare_dist(ctr_dist / 2);
+    [[maybe_unused]] size_t num_skipped = skipped_evals;
+
+    // a point only moves if it is closer to a, so stop summing past its current distance
+    for(size_t k = 0; k < b.points.size(); k++){
+        if(b.distances[k] < stay_dist){
+            a_distances.push_back(b.distances[k]);
+            skipped_evals++;
+        }
+        else
+            a_distances.push_back(metric.compare_dist_bounded(a_center, b.points[k], b.distances[k]));
+    }
+    num_skipped = skipped_evals - num_skipped;
+    stats_count(evals_skipped, num_skipped);
+    stats_count(dist_evals, b.points.size() - num_skipped);
     
     bool farthest_moved = a_distances[0] < b.distances[0];
 
@@ -142,6 +178,7 @@ void NeighborGraph<d, Metric>::rebalance(size_t i, size_t j){
     if(l_i != b.points.size()){
         // mark the current cell as affected
         affected_cells.push_back(j);
+        stats_count(points_moved, b.points.size() - l_i);
 
         // move the points to a
         // a.points.insert(a.points.end(),
@@ -157,15 +194,17 @@ void NeighborGraph<d, Metric>::rebalance(size_t i, size_t j){
         b.distances.erase(b.distances.begin()+l_i, b.distances.end());
         // b.distances.shrink_to_fit();
         // update the radius of b
-        if(farthest_moved)
+        if(farthest_moved){
             b.update_radius();
+            cell_heap.update(j, heap_key(j));
+        }
     }
 
     a_distances.clear();
 }
 
 // template <std::size_t d, typename Metric>
-// void NeighborGraph<d, Metric>::rebalance(size_t i, size_t j){
+// void NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::rebalance(size_t i, size_t j){
 //     debug_log("rebalance: PL on " << cells[j].points.size() << " points from " << cells[j].center << " to " << cells[i].center);
     
 //     CellRef a = cells[i];
@@ -245,30 +284,46 @@ void NeighborGraph<d, Metric>::rebalance(size_t i, size_t j){
 //     keep_pts.clear();
 // }
 
-template <std::size_t d, typename Metric>
-inline std::pair<size_t, size_t> NeighborGraph<d, Metric>::init_new_cell(){
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+inline std::pair<size_t, size_t> NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::init_new_cell(){
+    stats_phase(new_cell);
     // get the cell at the top of the cell heap
     size_t par = heap_top();
     // extract its farthest point
     Pt center = std::move(cells[par].pop_farthest());
+    cell_heap.update(par, heap_key(par));
     
     // create new cell centered at this point
     debug_log("add_cell: New center is " << center);
-    cells.push_back(Cell(std::move(center), metric));
+    cells.push_back(CellT(std::move(center), metric));
     // add edge from new cell to itself
     size_t newcell_i = cells.size()-1;
-    cells.back().nbrs.push_back(newcell_i);
+    nbrs.add_vertex();
+    nbrs.push_back(newcell_i, newcell_i);
+    visited.push_back(0);
 
     return std::pair<size_t, size_t>({par, newcell_i});
 }
 
-template <std::size_t d, typename Metric>
-inline void NeighborGraph<d, Metric>::point_location(size_t cell_i, size_t par_i){
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+inline void NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::point_location(size_t cell_i, size_t par_i){
+    stats_phase(point_location);
     // clear affected cells
     affected_cells.clear();
     // move points from each nbr of parent to the new cell
-    for(size_t i: cells[par_i].nbrs)
-        rebalance(cell_i, i);
+    const Pt& center = cells[cell_i].center;
+    for(size_t i: nbrs[par_i]){
+        // if the new center is beyond twice the radius of cell i, every point
+        // of cell i is closer to its own center and the cell is left untouched
+        double ctr_dist = metric.dist_bounded(center, cells[i].center, 2 * cells[i].radius);
+        stats_count(dist_evals, 1);
+        if(ctr_dist > 2 * cells[i].radius){
+            skipped_cells++;
+            stats_count(cells_skipped, 1);
+            continue;
+        }
+        rebalance(cell_i, i, ctr_dist);
+    }
     // compute the radius of the new cell
     cells[cell_i].update_radius();
     // no other point from parent may have moved, but even then parent is to marked as affected
@@ -276,87 +331,70 @@ inline void NeighborGraph<d, Metric>::point_location(size_t cell_i, size_t par_i
         affected_cells.push_back(par_i);
 }
 
-template <std::size_t d, typename Metric>
-inline void NeighborGraph<d, Metric>::nbr_nbr_update(size_t cell_i){
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+inline void NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::nbr_nbr_update(size_t cell_i){
+    stats_phase(nbr_nbr_update);
     debug_log("nbr_nbr_update: Finding nbrs of nbrs");
 
-    boost::unordered_flat_set<size_t> nbrs;
-    
-    // for nbrs of each affected nbr of parent, check if nbr of nbr is close enough
+    // a new epoch invalidates all marks at once; reset them only when the counter wraps
+    if(++epoch == 0){
+        std::fill(visited.begin(), visited.end(), 0);
+        epoch = 1;
+    }
+    // the new cell already lists itself
+    visited[cell_i] = epoch;
+
+    // for nbrs of each affected nbr of parent, check once if nbr of nbr is close enough
     for(size_t i: affected_cells)
-        for(size_t j: cells[i].nbrs)
+        for(size_t j: nbrs[i]){
+            if(visited[j] == epoch)
+                continue;
+            visited[j] = epoch;
             if(is_close_enough(cell_i, j))
-                nbrs.insert(j);
-    
-    // for each viable nbr of nbr, connect it to the new cell
+                new_nbrs.push_back(j);
+        }
+
+    // adding edges may move lists in the pool, so connect them only after the scan
     debug_log("nbr_nbr_update: Nbrs discovered");
-    cells[cell_i].nbrs.reserve(nbrs.size());
-    for(size_t i: nbrs){
-        debug_log("nbr_nbr_update: Adding edge between " << cells[i].center << " and " << cells[cell_i].center);
-        add_edge(cell_i, i);
+    nbrs.reserve(cell_i, new_nbrs.size());
+    for(size_t j: new_nbrs){
+        debug_log("nbr_nbr_update: Adding edge between " << cells[j].center << " and " << cells[cell_i].center);
+        add_edge(cell_i, j);
     }
+    new_nbrs.clear();
 }
 
-template <std::size_t d, typename Metric>
-inline void NeighborGraph<d, Metric>::prune_edges(){
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+inline void NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::prune_edges(){
+    stats_phase(prune_edges);
     debug_log("prune_edges: Pruning long edges");
     // prune each affected nbrs
     // it should be noted that this pruning implementation is not bidirectional
     for(size_t i: affected_cells){
         // check which edges with cells[i] can be pruned
-        auto iter = std::remove_if(cells[i].nbrs.begin(), cells[i].nbrs.end(), 
-                [&](const size_t j){
+        // the chunk of the list is kept as the number of edges can grow
+        [[maybe_unused]] size_t degree = nbrs.degree(i);
+        nbrs.remove_if(i, [&](const size_t j){
                     return !(is_close_enough(i, j));
                 });
-        // now cells[i].nbrs.begin() ... iter cannot be pruned
-        // so we prune the remaining edges
-        cells[i].nbrs.erase(iter, cells[i].nbrs.end());
-        // not calling shrink to fit as the number of edges can grow
+        stats_count(edges_pruned, degree - nbrs.degree(i));
     }
 }
 
-template<size_t d, typename Metric>
-bool NeighborGraph<d, Metric>::CellCompare::operator()(
-                const HeapPair& a,
-                const HeapPair& b
-    ) const {
-    auto& [a_i, a_r] = a;
-    auto& [b_i, b_r] = b;
-    if (a_r != b_r)
-        return a_r < b_r;
-    return a_i < b_i;  // unique tiebreaker
-}
-
-template<size_t d, typename Metric>
-size_t NeighborGraph<d, Metric>::heap_top(){
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+size_t NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::heap_top(){
     if(centers_moved){
         debug_log("heap_top: Cells do not exist");
         return -1;
     }
-    while (!cell_heap.empty()) {
-        // access the top element
-        auto [i, r] = cell_heap.top();
-        // current radius of this cell
-        double c_r = cells[i].radius;
-        // if the radius on the heap is stale, update it
-        if(r > c_r){
-            // pop top moves highest priority element to back of vector
-            cell_heap.pop();
-            // update priority and push it back into the heap
-            cell_heap.push(HeapPair({i, c_r}));
-        }
-        // else return it
-        else{
-            debug_log("heap_top: Getting top of heap: " << cells[i].center << " cell radius " << cells[i].radius);
-            return i;
-        }
-    }
-    // should never be called
-    return -1;
+    // radii are updated in place, so the top of the heap is never stale
+    size_t i = cell_heap.top();
+    debug_log("heap_top: Getting top of heap: " << cells[i].center << " cell radius " << cells[i].radius);
+    return i;
 }
 
-template<size_t d, typename Metric>
-void NeighborGraph<d, Metric>::get_permutation(bool move, std::vector<Pt>& output){
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+void NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::get_permutation(bool move, std::vector<Pt>& output){
     output.clear();
     if(centers_moved){
         debug_log("get_permutation: Cells do not exist");
@@ -374,4 +412,22 @@ void NeighborGraph<d, Metric>::get_permutation(bool move, std::vector<Pt>& outpu
         for(auto&c: cells)
             output.push_back(c.center);
     }
-}
\ No newline at end of file
+}
+template <std::size_t d, typename Metric, typename PtT, typename Heap, typename Idx, typename Alloc>
+void NeighborGraph<d, Metric, PtT, Heap, Idx, Alloc>::memory_usage(MemoryReport& report) const{
+    size_t points = 0, distances = 0;
+    for(auto& c: cells){
+        points += capacity_bytes(c.points);
+        distances += capacity_bytes(c.distances);
+    }
+    report.add("cells", capacity_bytes(cells));
+    report.add("Cell::points", points);
+    report.add("Cell::distances", distances);
+    report.add("nbrs", nbrs.capacity_bytes());
+    report.add("cell_heap", cell_heap.capacity_bytes());
+    report.add("scratch", capacity_bytes(affected_cells) + capacity_bytes(new_nbrs)
+                        + capacity_bytes(a_distances) + capacity_bytes(visited)
+                        + capacity_bytes(move_pts) + capacity_bytes(keep_pts)
+                        + capacity_bytes(move_dists) + capacity_bytes(keep_dists)
+                        + capacity_bytes(move_idx) + capacity_bytes(keep_idx));
+}
@@ -0,0 +1,95 @@
+/**
+ * @file packed_gt.hpp
+ * @author Siddarth Sheth
+ * @brief A compact copy of a fast_gt layout for nearest neighbor search, with
+ *        the fields read together stored together.
+ *
+ * Expanding a node of a fast_gt layout reads three places: the split of the
+ * node in aux, the center of its right child in G, and the split of that child
+ * in aux again. PackedGT keeps, next to each center, the radius and size of
+ * the largest subtree centered there and the size of its left child, so the
+ * right child is read from one place. Splits further down the left chain keep
+ * a float radius and a 32-bit count, in 8 bytes instead of 16, but stay in a
+ * separate array: each expansion still reads splits twice, for the left child
+ * and for the size that locates its next right child. The two entries are
+ * adjacent, so they usually share a cache line. Positions are the same as in G,
+ * so answers can be used with G directly.
+ *
+ * PackedGT is a second full copy of the points next to G. The Layout/
+ * benchmarks compare it with G and aux on trees larger than the caches, by
+ * query latency and, where the PMU is available, by L1 data and last-level
+ * cache misses per query.
+ */
+
+#ifndef PACKED_GT_H
+#define PACKED_GT_H
+
+#include "fast_search_impl.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The center at a position of G with the top split of its subtree.
+ */
+template<typename PtT>
+struct PackedNode {
+    PtT center;
+    float rad;              // radius of the largest subtree centered here, rounded up
+    std::uint32_t size;     // its number of points
+    std::uint32_t chain;    // index of its split in PackedGT::splits
+    std::uint32_t left;     // number of points of its left child
+};
+
+/**
+ * @brief Radius, rounded up, and number of points of a node, as in aux.
+ */
+struct PackedSplit {
+    float rad;
+    std::uint32_t size;
+};
+
+template<typename PtT>
+struct PackedGT {
+    std::vector<PackedNode<PtT>> nodes;     // by position in G
+    std::vector<PackedSplit> splits;        // by index in aux
+};
+
+/**
+ * @brief Build the packed copy of a fast_gt layout of fewer than 2^32 points.
+ *
+ * Throws std::length_error if aux has more entries than a 32-bit count can index.
+ */
+template<typename PtT, typename Idx>
+void pack_gt(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux, PackedGT<PtT>& output);
+
+/**
+ * @brief Nearest neighbor search over a PackedGT, with the same answers as ApxNNSearch.
+ *
+ * When a node is pushed on the frontier, the center of the right child it
+ * will split off next is prefetched, so that it is in cache by the time the
+ * node is expanded.
+ */
+template<size_t d, typename Metric, typename PtT = Point<d>, typename Idx = size_t>
+class PackedNNSearch {
+    using EdgeVec = EdgeVecT<Idx>;
+
+    const PackedGT<PtT>& T;
+    Metric& metric;
+
+    LowerBoundComparator nearer;
+
+    public:
+    PackedNNSearch(const PackedGT<PtT>& T, Metric& metric): T(T), metric(metric){}
+
+    /**
+     * @brief Position of the nearest neighbor of q, or with e > 0 of a point at most (1 + e) times as far.
+     */
+    Idx operator()(const PtT& q, double e=0);
+};
+
+template<typename PtT>
+void memory_usage(const PackedGT<PtT>& T, MemoryReport& report);
+
+#include "packed_gt_impl.hpp"
+
+#endif // PACKED_GT_H
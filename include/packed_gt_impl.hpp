@@ -0,0 +1,98 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+// The float nearest to r that is not below it, so that pruning with it stays safe.
+inline float round_up(double r){
+    float f = static_cast<float>(r);
+    return f < r ? std::nextafter(f, std::numeric_limits<float>::infinity()) : f;
+}
+
+template<typename PtT, typename Idx>
+void pack_gt(const std::vector<GTEntry<PtT, Idx>>& G, const GTDataT<Idx>& aux, PackedGT<PtT>& output){
+    // sizes, chains and left counts are stored in 32 bits
+    if(aux.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("pack_gt: more than 2^32 - 1 splits");
+    // reserve and advise before the first write, so that the pages start out huge
+    output.splits.clear();
+    output.splits.reserve(aux.size());
+    advise_huge_pages(output.splits);
+    output.splits.resize(aux.size());
+    for(size_t s = 0; s < aux.size(); s++)
+        output.splits[s] = {round_up(aux[s].first), static_cast<std::uint32_t>(aux[s].second)};
+
+    output.nodes.clear();
+    output.nodes.reserve(G.size());
+    advise_huge_pages(output.nodes);
+    output.nodes.resize(G.size());
+    for(size_t i = 0; i < G.size(); i++){
+        auto& [p, s] = G[i];
+        auto [rad, size] = output.splits[s];
+        std::uint32_t left = size > 1 ? output.splits[s + 1].size : 0;
+        output.nodes[i] = {p, rad, size, static_cast<std::uint32_t>(s), left};
+    }
+}
+
+template<size_t d, typename Metric, typename PtT, typename Idx>
+Idx PackedNNSearch<d, Metric, PtT, Idx>::operator()(const PtT& q, double e){
+    // a node is expanded soon after it is pushed, so its next right child is fetched then
+    auto prefetch = [&](Idx i){
+        const char* p = reinterpret_cast<const char*>(&T.nodes[i]);
+        for(size_t offset = 0; offset < sizeof(PackedNode<PtT>); offset += 64)
+            __builtin_prefetch(p + offset);
+    };
+
+    auto& root = T.nodes[0];
+    double nn_dist = metric.dist(root.center, q);
+    Idx nn = 0;
+    // a node is worth expanding while it may hold a point closer than nn_dist / (1 + e)
+    auto viable = [&](double dist, double rad){ return (1 + e) * (dist - rad) < nn_dist; };
+
+    EdgeVec nbrs;
+    if(viable(nn_dist, root.rad)){
+        prefetch(root.left);
+        nbrs.push_back({0, nn_dist, root.rad, root.size, root.chain});
+    }
+
+    while(!nbrs.empty()){
+        std::pop_heap(nbrs.begin(), nbrs.end(), nearer);
+        auto [a_i, a_dist, a_rad, a_pts, a_s] = nbrs.back();
+        nbrs.pop_back();
+
+        // every other node is at least as far, so nn is within a factor 1 + e
+        if(!viable(a_dist, a_rad))
+            break;
+
+        // the left child keeps the center of a and the right child starts after its points
+        auto [l_rad, l_pts] = T.splits[++a_s];
+        Idx b_i = a_i + l_pts;
+        auto& b = T.nodes[b_i];
+
+        // beyond nn_dist + b.rad the right child is pruned and cannot improve nn
+        double b_dist = metric.dist_bounded(q, b.center, nn_dist + b.rad);
+        if(b_dist < nn_dist){
+            nn_dist = b_dist;
+            nn = b_i;
+        }
+
+        if(viable(b_dist, b.rad)){
+            prefetch(b_i + b.left);
+            nbrs.push_back({b_i, b_dist, b.rad, b.size, b.chain});
+            std::push_heap(nbrs.begin(), nbrs.end(), nearer);
+        }
+
+        if(viable(a_dist, l_rad)){
+            prefetch(a_i + T.splits[a_s + 1].size);
+            nbrs.push_back({a_i, a_dist, l_rad, l_pts, a_s});
+            std::push_heap(nbrs.begin(), nbrs.end(), nearer);
+        }
+    }
+    return nn;
+}
+
+template<typename PtT>
+void memory_usage(const PackedGT<PtT>& T, MemoryReport& report){
+    report.add("PackedGT nodes", capacity_bytes(T.nodes));
+    report.add("PackedGT splits", capacity_bytes(T.splits));
+}
@@ -17,43 +17,45 @@
 #include <stdexcept>
 #include <functional>  // std::hash
 #include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint64_t
+#include <tuple>       // std::tuple_size
+#include <cmath>       // std::sqrt
+#include <type_traits>
 #include "metrics.hpp"
 
 // Include fstream for file output
 #include <fstream>
 
-// Uncomment to enable debug logging
+// Uncomment to enable debug logging, console output or build statistics (see stats.hpp)
 // #define DEBUG
-#define DISPLAY
+// #define DISPLAY
 // #define STAT
 
+#include "stats.hpp"
+
 #ifdef DEBUG
-// Open a global debug stream (append mode so logs persist)
-static std::ofstream debug_stream("debug.log", std::ios::app);
+/**
+ * @brief Debug log shared by all translation units (append mode so logs persist).
+ */
+inline std::ofstream& debug_stream() {
+    static std::ofstream stream("debug.log", std::ios::app);
+    return stream;
+}
 
-#define debug_log(x) debug_stream << x << std::endl
+#define debug_log(x) debug_stream() << x << std::endl
 #else
 #define debug_log(x) do {} while (0)
 #endif
 
 /**
- * @brief Macro for debug logging. Prints to std::cout if DISPLAY is defined, otherwise does nothing.
+ * @brief Macro for console output. Prints to std::cout if DISPLAY is defined, otherwise does nothing.
  */
 #ifdef DISPLAY
-static std::ofstream display_stream("display.log", std::ios::app);
-// #  define display_log(x) display_stream << x << std::endl
 #  define display_log(x) std::cout << x << std::endl
 #else
 #  define display_log(x) do {} while (0)
 #endif
 
-#ifdef STAT
-static std::ofstream stat_stream("stats.csv", std::ios::app);
-#  define stat_log(x) stat_stream << x << std::endl
-#else
-#  define stat_log(x) do {} while (0)
-#endif
-
 // Forward declaration for friend operator<<
 template <std::size_t d, typename Metric>
 std::ostream& operator<<(std::ostream& os, const std::array<double, d>& p);
@@ -143,15 +145,56 @@ std::ostream& operator<<(std::ostream& os, const std::array<double, d>& p);
 // template <std::size_t d, typename Metric>
 // const Point<d, Metric> origin;
 
+/**
+ * @brief Packed binary code of the given number of bits, for use with HammingMetric.
+ * @tparam bits Number of bits in the code.
+ */
+template <std::size_t bits>
+using BitPoint = std::array<std::uint64_t, (bits + 63) / 64>;
+
+/**
+ * @brief A vector together with its cached L2 norm, for use with AngularMetric.
+ * @tparam d Dimensionality of the point.
+ */
+template <std::size_t d>
+struct NormedPoint {
+    std::array<double, d> coords;
+    double norm;
+
+    NormedPoint(): coords(), norm(0) {}
+    NormedPoint(const std::array<double, d>& coords): coords(coords) {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < d; ++i)
+            sum += coords[i] * coords[i];
+        norm = std::sqrt(sum);
+    }
+
+    bool operator==(const NormedPoint& other) const { return coords == other.coords; }
+    bool operator!=(const NormedPoint& other) const { return coords != other.coords; }
+};
+
+/**
+ * @brief Dimension parameter used for a point type in the class templates.
+ *
+ * For std::array points this is the number of entries, i.e. d for coordinates
+ * and the number of 64-bit words for a BitPoint. Specialize it for other point types.
+ */
+template <typename PtT>
+struct point_dim : std::tuple_size<PtT> {};
+
+template <std::size_t d>
+struct point_dim<NormedPoint<d>> : std::integral_constant<std::size_t, d> {};
+
 /**
  * @brief Output operator for Point.
+ * @tparam T Coordinate type.
  * @tparam d Dimensionality.
  * @param os Output stream.
  * @param p Point to print.
  * @return Reference to output stream.
  */
-template <std::size_t d>
-std::ostream& operator<<(std::ostream& os, const std::array<double, d>& p) {
+template <typename T, std::size_t d>
+std::ostream& operator<<(std::ostream& os, const std::array<T, d>& p) {
     os << "(";
     for (std::size_t i = 0; i < d; ++i) {
         os << p[i];
@@ -161,6 +204,14 @@ std::ostream& operator<<(std::ostream& os, const std::array<double, d>& p) {
     return os;
 }
 
+/**
+ * @brief Output operator for NormedPoint; prints the coordinates.
+ */
+template <std::size_t d>
+std::ostream& operator<<(std::ostream& os, const NormedPoint<d>& p) {
+    return os << p.coords;
+}
+
 // Helper function to combine hashes (from Boost)
 inline void hash_combine(std::size_t& seed, std::size_t value) {
     seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
@@ -183,6 +234,27 @@ namespace std {
     };
 }
 
+/**
+ * @brief Hash for every point type, passed explicitly to unordered containers.
+ *
+ * std::hash is only specialized for Point; codes such as BitPoint are arrays
+ * of standard types, which the project may not specialize std::hash for.
+ */
+struct PointHash {
+    template <typename T, std::size_t d>
+    std::size_t operator()(const std::array<T, d>& p) const{
+        size_t seed = 0;
+        for (size_t i = 0; i < d; ++i)
+            hash_combine(seed, std::hash<T>{}(p[i]));
+        return seed;
+    }
+
+    template <std::size_t d>
+    std::size_t operator()(const NormedPoint<d>& p) const{
+        return (*this)(p.coords);
+    }
+};
+
 // #include "point_impl.hpp"
 
 #endif // POINT_H
\ No newline at end of file
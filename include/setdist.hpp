@@ -0,0 +1,62 @@
+/**
+ * @file setdist.hpp
+ * @author Siddarth Sheth
+ * @brief Hausdorff distance and closest pair between two point sets, by dual-tree search.
+ *
+ * Both sets are given as fast_gt layouts. Every node center is a point of its
+ * set, so each center distance that is evaluated is also a candidate answer,
+ * and the radii bound how much the answer can change inside a pair of nodes.
+ * With e > 0 the searches stop as soon as the answer is known within a factor
+ * of 1 + e.
+ */
+
+#ifndef SETDIST_H
+#define SETDIST_H
+
+#include "fast_search_impl.hpp"
+#include <vector>
+#include <utility>
+#include <limits>
+
+/**
+ * @brief A closest pair: positions a and b in the two layouts and their distance.
+ */
+template<typename Idx = size_t>
+struct ClosestPair {
+    Idx a, b;
+    double dist;
+};
+
+/**
+ * @brief Directed Hausdorff distance max_{a in A} min_{b in B} dist(a, b).
+ *
+ * @return A value h' with h / (1 + e) <= h' <= h, where h is the exact distance;
+ *         0 if A is empty and infinity if only B is empty.
+ */
+template<typename PtT, typename Idx, typename Metric>
+double directed_hausdorff(const std::vector<GTEntry<PtT, Idx>>& G_A, const GTDataT<Idx>& aux_a,
+                          const std::vector<GTEntry<PtT, Idx>>& G_B, const GTDataT<Idx>& aux_b,
+                          Metric metric, double e = 0);
+
+/**
+ * @brief Hausdorff distance, the larger of the two directed distances, within the same factor.
+ */
+template<typename PtT, typename Idx, typename Metric>
+double hausdorff(const std::vector<GTEntry<PtT, Idx>>& G_A, const GTDataT<Idx>& aux_a,
+                 const std::vector<GTEntry<PtT, Idx>>& G_B, const GTDataT<Idx>& aux_b,
+                 Metric metric, double e = 0);
+
+/**
+ * @brief Bichromatic closest pair of A and B.
+ *
+ * @return A pair whose distance is at most (1 + e) times the smallest one; the
+ *         distance is infinity if either set is empty.
+ */
+template<typename PtT, typename Idx, typename Metric>
+ClosestPair<Idx> closest_pair(const std::vector<GTEntry<PtT, Idx>>& G_A, const GTDataT<Idx>& aux_a,
+                              const std::vector<GTEntry<PtT, Idx>>& G_B, const GTDataT<Idx>& aux_b,
+                              Metric metric, double e = 0);
+
+#include "setdist_impl.hpp"
+
+#endif // SETDIST_H
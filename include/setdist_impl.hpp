@@ -0,0 +1,143 @@
+#include <stack>
+#include <tuple>
+#include <algorithm>
+
+/**
+ * @brief Directed Hausdorff search from A to B that starts from a lower bound h.
+ *
+ * Query nodes of A are taken from a stack with their candidate nodes of B, as
+ * in the batch nearest-neighbor search: candidates larger than the query node
+ * are split first, then the query node itself. A query node is dropped as soon
+ * as none of its points can be farther than (1 + e) h from B.
+ */
+template<typename PtT, typename Idx, typename Metric>
+double hausdorff_from(const std::vector<GTEntry<PtT, Idx>>& G_A, const GTDataT<Idx>& aux_a,
+                      const std::vector<GTEntry<PtT, Idx>>& G_B, const GTDataT<Idx>& aux_b,
+                      Metric& metric, double e, double h){
+    using Node = GTSubtree<Idx>;
+    using Cand = std::pair<Node, double>;               // node of B, distance between the centers
+    using Search = std::pair<Node, std::vector<Cand>>;
+    auto smaller = [&](const Cand& u, const Cand& v){ return u.first.rad(aux_b) < v.first.rad(aux_b); };
+
+    std::stack<Search> to_process;
+    to_process.push({Node::root(), {{Node::root(), 0}}});
+    while(!to_process.empty()){
+        auto [a, cands] = std::move(to_process.top());
+        to_process.pop();
+        const auto& a_ctr = G_A[a.i].first;
+        double a_rad = a.rad(aux_a);
+
+        // the centers are points of B, so nn_dist bounds the distance from a_ctr to B
+        double nn_dist = std::numeric_limits<double>::max();
+        for(auto& [b, b_dist]: cands){
+            b_dist = metric.dist_bounded(a_ctr, G_B[b.i].first, nn_dist + 2*a_rad + b.rad(aux_b));
+            nn_dist = std::min(nn_dist, b_dist);
+        }
+        std::make_heap(cands.begin(), cands.end(), smaller);
+
+        while(true){
+            // every point of a is within a_rad + nn_dist of B
+            if(a_rad + nn_dist <= (1 + e) * h)
+                break;
+            auto [b, b_dist] = cands.front();
+            double b_rad = b.rad(aux_b);
+            if(b_rad > a_rad){
+                std::pop_heap(cands.begin(), cands.end(), smaller);
+                cands.pop_back();
+                // b is too far to hold the nearest neighbor of any point of a
+                if(b_dist - b_rad - a_rad > nn_dist + a_rad)
+                    continue;
+                Node l = b.left(), r = b.right(G_B, aux_b);
+                double r_dist = metric.dist_bounded(a_ctr, G_B[r.i].first, nn_dist + 2*a_rad + r.rad(aux_b));
+                nn_dist = std::min(nn_dist, r_dist);
+                cands.push_back({l, b_dist});
+                std::push_heap(cands.begin(), cands.end(), smaller);
+                cands.push_back({r, r_dist});
+                std::push_heap(cands.begin(), cands.end(), smaller);
+            }
+            else if(a_rad > 0){
+                // split the query node; the left child keeps the center and the distances
+                to_process.push({a.right(G_A, aux_a), cands});
+                a = a.left();
+                a_rad = a.rad(aux_a);
+            }
+            else {
+                // a and all its candidates are single points, so nn_dist is exact
+                h = nn_dist;
+                break;
+            }
+        }
+    }
+    return h;
+}
+
+template<typename PtT, typename Idx, typename Metric>
+double directed_hausdorff(const std::vector<GTEntry<PtT, Idx>>& G_A, const GTDataT<Idx>& aux_a,
+                          const std::vector<GTEntry<PtT, Idx>>& G_B, const GTDataT<Idx>& aux_b,
+                          Metric metric, double e){
+    if(G_A.empty())
+        return 0;
+    if(G_B.empty())
+        return std::numeric_limits<double>::infinity();
+    return hausdorff_from(G_A, aux_a, G_B, aux_b, metric, e, 0);
+}
+
+template<typename PtT, typename Idx, typename Metric>
+double hausdorff(const std::vector<GTEntry<PtT, Idx>>& G_A, const GTDataT<Idx>& aux_a,
+                 const std::vector<GTEntry<PtT, Idx>>& G_B, const GTDataT<Idx>& aux_b,
+                 Metric metric, double e){
+    if(G_A.empty() && G_B.empty())
+        return 0;
+    if(G_A.empty() || G_B.empty())
+        return std::numeric_limits<double>::infinity();
+    // the first direction is a lower bound that prunes the second
+    double h = hausdorff_from(G_A, aux_a, G_B, aux_b, metric, e, 0);
+    return hausdorff_from(G_B, aux_b, G_A, aux_a, metric, e, h);
+}
+
+template<typename PtT, typename Idx, typename Metric>
+ClosestPair<Idx> closest_pair(const std::vector<GTEntry<PtT, Idx>>& G_A, const GTDataT<Idx>& aux_a,
+                              const std::vector<GTEntry<PtT, Idx>>& G_B, const GTDataT<Idx>& aux_b,
+                              Metric metric, double e){
+    using Node = GTSubtree<Idx>;
+    using NodePair = std::tuple<double, Node, Node, double>;   // lower bound, a, b, distance between the centers
+    auto farther = [](const NodePair& u, const NodePair& v){ return std::get<0>(u) > std::get<0>(v); };
+
+    ClosestPair<Idx> best{0, 0, std::numeric_limits<double>::infinity()};
+    if(G_A.empty() || G_B.empty())
+        return best;
+
+    // pairs of nodes are searched in order of the smallest distance they could hold
+    std::vector<NodePair> to_process;
+    auto visit = [&](Node a, Node b, double ab_dist){
+        if(ab_dist < best.dist)
+            best = {a.i, b.i, ab_dist};
+        double lower = std::max(0.0, ab_dist - a.rad(aux_a) - b.rad(aux_b));
+        if((1 + e) * lower < best.dist){
+            to_process.push_back({lower, a, b, ab_dist});
+            std::push_heap(to_process.begin(), to_process.end(), farther);
+        }
+    };
+
+    visit(Node::root(), Node::root(), metric.dist(G_A[0].first, G_B[0].first));
+    while(!to_process.empty()){
+        std::pop_heap(to_process.begin(), to_process.end(), farther);
+        auto [lower, a, b, ab_dist] = to_process.back();
+        to_process.pop_back();
+        if((1 + e) * lower >= best.dist)
+            break;
+        // split the larger node; its left child shares its center, so only the right child costs a distance
+        double a_rad = a.rad(aux_a), b_rad = b.rad(aux_b);
+        if(a_rad >= b_rad){
+            Node r = a.right(G_A, aux_a);
+            visit(a.left(), b, ab_dist);
+            visit(r, b, metric.dist_bounded(G_A[r.i].first, G_B[b.i].first, best.dist + r.rad(aux_a) + b_rad));
+        }
+        else {
+            Node r = b.right(G_B, aux_b);
+            visit(a, b.left(), ab_dist);
+            visit(a, r, metric.dist_bounded(G_A[a.i].first, G_B[r.i].first, best.dist + a_rad + r.rad(aux_b)));
+        }
+    }
+    return best;
+}
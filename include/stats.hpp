@@ -0,0 +1,205 @@
+/**
+ * @file stats.hpp
+ * @author Siddarth Sheth
+ * @brief Build instrumentation: event counters, phase timers and degree histograms.
+ *
+ * Instrumentation is compiled in only when STAT is defined. Otherwise the
+ * stats_count and stats_phase macros expand to nothing, so the build pays no
+ * cost for it. The collected values live in a single BuildStats object that
+ * can be queried or exported as JSON once the build is done.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Events counted during a build.
+ */
+enum class Counter {
+    dist_evals,     // distance evaluations made by the neighbor graph
+    points_moved,   // points moved to a new cell by rebalance
+    evals_skipped,  // point distances rebalance skipped with the triangle inequality
+    cells_skipped,  // donor cells point location skipped entirely
+    heap_skips,     // entries the cell queue passed over before finding its top
+    edges_added,    // neighbor list entries, two per undirected edge
+    edges_pruned,   // neighbor list entries removed, including the self entry of an emptied cell
+    num_counters
+};
+
+/**
+ * @brief Phases of NeighborGraph::add_cell that are timed separately.
+ */
+enum class Phase {
+    new_cell,       // heap top and promotion of the farthest point
+    point_location,
+    nbr_nbr_update,
+    prune_edges,
+    num_phases
+};
+
+/**
+ * @brief Distribution of the neighbor graph degrees at one point of the build.
+ */
+struct DegreeSample {
+    std::size_t num_cells;
+    double mean;
+    std::size_t max;
+    /**
+     * @brief hist[b] is the number of cells with degree in [2^b, 2^(b+1)); degree 0 is counted in hist[0].
+     */
+    std::vector<std::size_t> hist;
+};
+
+/**
+ * @brief Counters, timers and degree samples of a build.
+ *
+ * Counters and timers are relaxed atomics, so concurrent builds may report
+ * into the same object.
+ */
+class BuildStats {
+public:
+    BuildStats() { reset(); }
+
+    void reset() {
+        for (auto& c : counters)
+            c.store(0, std::memory_order_relaxed);
+        for (auto& t : phase_ns)
+            t.store(0, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(samples_mutex);
+        samples.clear();
+    }
+
+    void add(Counter c, std::uint64_t n = 1) {
+        counters[static_cast<std::size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void add_time(Phase p, std::uint64_t ns) {
+        phase_ns[static_cast<std::size_t>(p)].fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count(Counter c) const {
+        return counters[static_cast<std::size_t>(c)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Wall-clock time spent in a phase, in seconds.
+     */
+    double seconds(Phase p) const {
+        return phase_ns[static_cast<std::size_t>(p)].load(std::memory_order_relaxed) * 1e-9;
+    }
+
+    /**
+     * @brief Record the degree distribution of a graph with num_cells cells.
+     * @param degree Callable returning the degree of cell i.
+     */
+    template <typename Degree>
+    void sample_degrees(std::size_t num_cells, Degree degree) {
+        DegreeSample s{num_cells, 0, 0, {}};
+        double total = 0;
+        for (std::size_t i = 0; i < num_cells; i++) {
+            std::size_t deg = degree(i);
+            std::size_t b = 0;
+            while ((deg >> (b + 1)) != 0)
+                b++;
+            if (b >= s.hist.size())
+                s.hist.resize(b + 1, 0);
+            s.hist[b]++;
+            total += deg;
+            if (deg > s.max)
+                s.max = deg;
+        }
+        s.mean = num_cells ? total / num_cells : 0;
+        std::lock_guard<std::mutex> lock(samples_mutex);
+        samples.push_back(std::move(s));
+    }
+
+    const std::vector<DegreeSample>& degree_samples() const { return samples; }
+
+    void write_json(std::ostream& os) const {
+        os << "{\"counters\": {";
+        for (std::size_t i = 0; i < counters.size(); i++)
+            os << (i ? ", " : "") << '"' << counter_names[i] << "\": " << counters[i].load(std::memory_order_relaxed);
+        os << "}, \"phase_seconds\": {";
+        for (std::size_t i = 0; i < phase_ns.size(); i++)
+            os << (i ? ", " : "") << '"' << phase_names[i] << "\": " << phase_ns[i].load(std::memory_order_relaxed) * 1e-9;
+        os << "}, \"degree_samples\": [";
+        for (std::size_t i = 0; i < samples.size(); i++) {
+            const DegreeSample& s = samples[i];
+            os << (i ? ", " : "") << "{\"num_cells\": " << s.num_cells
+               << ", \"mean\": " << s.mean << ", \"max\": " << s.max << ", \"hist\": [";
+            for (std::size_t b = 0; b < s.hist.size(); b++)
+                os << (b ? ", " : "") << s.hist[b];
+            os << "]}";
+        }
+        os << "]}";
+    }
+
+    std::string json() const {
+        std::ostringstream os;
+        write_json(os);
+        return os.str();
+    }
+
+private:
+    static constexpr std::size_t num_counters = static_cast<std::size_t>(Counter::num_counters);
+    static constexpr std::size_t num_phases = static_cast<std::size_t>(Phase::num_phases);
+
+    static constexpr const char* counter_names[num_counters] = {
+        "dist_evals", "points_moved", "evals_skipped", "cells_skipped",
+        "heap_skips", "edges_added", "edges_pruned"};
+    static constexpr const char* phase_names[num_phases] = {
+        "new_cell", "point_location", "nbr_nbr_update", "prune_edges"};
+
+    std::array<std::atomic<std::uint64_t>, num_counters> counters;
+    std::array<std::atomic<std::uint64_t>, num_phases> phase_ns;
+    std::vector<DegreeSample> samples;
+    std::mutex samples_mutex;
+};
+
+/**
+ * @brief The BuildStats object that the instrumentation macros report to.
+ */
+inline BuildStats& build_stats() {
+    static BuildStats stats;
+    return stats;
+}
+
+/**
+ * @brief Adds the time between construction and destruction to a phase.
+ */
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase p): phase(p), start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+        build_stats().add_time(phase, ns);
+    }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef STAT
+#  define stats_count(c, n) build_stats().add(Counter::c, n)
+#  define stats_phase(p) PhaseTimer stats_phase_timer_##p(Phase::p)
+#else
+#  define stats_count(c, n) do {} while (0)
+#  define stats_phase(p) do {} while (0)
+#endif
+
+#endif // STATS_H
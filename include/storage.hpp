@@ -0,0 +1,181 @@
+/**
+ * @file storage.hpp
+ * @author Siddarth Sheth
+ * @brief Storage policy for the large arrays: cache-line aligned point rows and
+ *        transparent huge pages.
+ *
+ * Random traversals of a large tree miss the TLB on almost every node when
+ * the arrays sit on 4 KB pages. Where the OS allows it (Linux with transparent
+ * huge pages in madvise or always mode), the arrays reserved by fast_gt,
+ * pack_gt and the cells of clarkson are advised to use huge pages, subject to
+ * storage_policy(), and the points of the cells come from CellAllocator. Point rows are aligned by choosing AlignedPoint as the
+ * point type, and arrays owned by the caller, e.g. those read through a
+ * PtView, can use HugePageAllocator.
+ *
+ * The advice takes effect when a page is first written. A vector that reuses
+ * heap memory written before keeps its small pages until khugepaged
+ * collapses them, so HugePageAllocator, whose large blocks are fresh and
+ * start on a huge page, is the dependable route for the largest arrays.
+ */
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "point.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+inline constexpr std::size_t cache_line_bytes = 64;
+inline constexpr std::size_t huge_page_bytes = std::size_t(2) << 20;
+
+/**
+ * @brief Whether and from what size the large arrays are put on huge pages.
+ */
+struct StoragePolicy {
+    bool huge_pages = true;
+    std::size_t huge_page_min_bytes = 4 * huge_page_bytes;
+};
+
+/**
+ * @brief The StoragePolicy that the builds and HugePageAllocator follow.
+ */
+inline StoragePolicy& storage_policy() {
+    static StoragePolicy policy;
+    return policy;
+}
+
+/**
+ * @brief Ask the OS to back the huge-page-aligned part of [p, p + bytes) with huge pages.
+ * @return False if the OS does not support it or the range holds no whole huge page.
+ */
+inline bool advise_huge_pages(const void* p, std::size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    auto start = reinterpret_cast<std::uintptr_t>(p);
+    auto begin = (start + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes;
+    auto end = (start + bytes) / huge_page_bytes * huge_page_bytes;
+    if (begin >= end)
+        return false;
+    return madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) == 0;
+#else
+    (void)p;
+    (void)bytes;
+    return false;
+#endif
+}
+
+/**
+ * @brief Advise the capacity of v for huge pages if storage_policy() asks for it.
+ *
+ * Call it right after reserving, before the pages are first written.
+ */
+template <typename T, typename A>
+bool advise_huge_pages(const std::vector<T, A>& v) {
+    std::size_t bytes = v.capacity() * sizeof(T);
+    const StoragePolicy& policy = storage_policy();
+    if (!policy.huge_pages || bytes < policy.huge_page_min_bytes)
+        return false;
+    return advise_huge_pages(v.data(), bytes);
+}
+
+/**
+ * @brief Allocator whose blocks are aligned to Align bytes, and to a huge page
+ * and advised for huge pages when they are large enough for storage_policy().
+ */
+template <typename T, std::size_t Align = cache_line_bytes>
+struct HugePageAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = HugePageAllocator<U, Align>; };
+
+    HugePageAllocator() = default;
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U, Align>&) {}
+
+    T* allocate(std::size_t n) {
+        std::size_t bytes = n * sizeof(T);
+        const StoragePolicy& policy = storage_policy();
+        bool huge = policy.huge_pages && bytes >= policy.huge_page_min_bytes;
+        std::size_t align = huge ? huge_page_bytes : std::max(Align, alignof(T));
+        // aligned_alloc takes a size that is a multiple of the alignment
+        bytes = (bytes + align - 1) / align * align;
+        void* p = std::aligned_alloc(align, bytes);
+        if (!p)
+            throw std::bad_alloc();
+        if (huge)
+            advise_huge_pages(p, bytes);
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t) { std::free(p); }
+
+    friend bool operator==(const HugePageAllocator&, const HugePageAllocator&) { return true; }
+    friend bool operator!=(const HugePageAllocator&, const HugePageAllocator&) { return false; }
+};
+
+/**
+ * @brief Allocator of the points held by the cells of clarkson: the small
+ * cells are allocated as by malloc, the large ones on huge pages.
+ */
+template <typename T>
+using CellAllocator = HugePageAllocator<T, alignof(std::max_align_t)>;
+
+// The smallest power of two that holds a row of the given size, up to a cache
+// line, e.g. AlignedPoint<d, row_alignment(d * sizeof(double))> for tight rows.
+constexpr std::size_t row_alignment(std::size_t bytes) {
+    std::size_t align = alignof(double);
+    while (align < bytes && align < cache_line_bytes)
+        align *= 2;
+    return align;
+}
+
+/**
+ * @brief Coordinates that start on an Align-byte boundary, without padding of their own.
+ *
+ * The metrics take a pair of them through an aligned-load path. AlignedPoint
+ * is the padded row that guarantees the alignment; an entry of GTPoints holds
+ * an AlignedRow at its start and its aux index in the padding after it.
+ */
+template <std::size_t d, std::size_t Align>
+struct AlignedRow : std::array<double, d> {
+    AlignedRow(): std::array<double, d>() {}
+    AlignedRow(const std::array<double, d>& p): std::array<double, d>(p) {}
+};
+
+/**
+ * @brief Coordinates aligned and padded to a multiple of Align bytes, a cache
+ * line by default, so that no row straddles a cache line more than it has to.
+ *
+ * It is a std::array<double, d>, so the metrics take it as is, and two rows
+ * of the same alignment are compared with aligned loads. A row of 3 doubles
+ * takes 64 bytes instead of 24; a smaller Align, such as row_alignment(24) =
+ * 32, trades that padding for rows that may share a line.
+ */
+template <std::size_t d, std::size_t Align = cache_line_bytes>
+struct alignas(Align) AlignedPoint : AlignedRow<d, Align> {
+    AlignedPoint(): AlignedRow<d, Align>() {}
+    AlignedPoint(const std::array<double, d>& p): AlignedRow<d, Align>(p) {}
+};
+
+template <std::size_t d, std::size_t Align>
+struct point_dim<AlignedPoint<d, Align>> : std::integral_constant<std::size_t, d> {};
+
+/**
+ * @brief Copy points into aligned rows.
+ */
+template <std::size_t d>
+std::vector<AlignedPoint<d>> aligned_points(const std::vector<std::array<double, d>>& pts) {
+    return std::vector<AlignedPoint<d>>(pts.begin(), pts.end());
+}
+
+#endif // STORAGE_H
@@ -1,12 +1,111 @@
 #ifndef MEMORY_UTILS_HPP
 #define MEMORY_UTILS_HPP
 
+#if defined(__APPLE__)
 #include <malloc/malloc.h>
-#include <iostream>
 #include <mach/mach.h>
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
 #include <numeric>
 #include <cmath>
+#include <cstddef>
+
+/**
+ * @brief Resident memory of the current process, in bytes.
+ */
+struct ProcessMemory {
+    std::size_t rss = 0;
+    std::size_t peak_rss = 0;
+};
+
+/**
+ * @brief Read the resident set size and its high-water mark.
+ *
+ * On Linux the values come from VmRSS and VmHWM in /proc/self/status; on macOS
+ * from the Mach task info. Fields that cannot be read are left at 0.
+ */
+inline ProcessMemory process_memory() {
+    ProcessMemory mem;
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        std::size_t* field = nullptr;
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            field = &mem.rss;
+        else if (line.compare(0, 6, "VmHWM:") == 0)
+            field = &mem.peak_rss;
+        if (field) {
+            std::istringstream value(line.substr(6));
+            std::size_t kb = 0;
+            value >> kb;
+            *field = kb * 1024;
+        }
+    }
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+        mem.rss = info.resident_size;
+        mem.peak_rss = info.resident_size_max;
+    }
+#endif
+    return mem;
+}
+
+/**
+ * @brief Bytes held by named data structures, as reported by their own size and capacity.
+ */
+struct MemoryReport {
+    std::vector<std::pair<std::string, std::size_t>> entries;
+
+    void add(const std::string& name, std::size_t bytes) {
+        entries.push_back({name, bytes});
+    }
+
+    std::size_t total() const {
+        std::size_t sum = 0;
+        for (auto& [name, bytes] : entries)
+            sum += bytes;
+        return sum;
+    }
+
+    /**
+     * @brief Bytes of the entry with the given name, or 0 if there is none.
+     */
+    std::size_t bytes(const std::string& name) const {
+        for (auto& [entry, bytes] : entries)
+            if (entry == name)
+                return bytes;
+        return 0;
+    }
+};
+
+/**
+ * @brief Bytes allocated by a vector, excluding the vector object itself.
+ */
+template <typename T, typename Alloc>
+inline std::size_t capacity_bytes(const std::vector<T, Alloc>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+inline void display_memory(const MemoryReport& report, std::ostream& os = std::cout) {
+    ProcessMemory mem = process_memory();
+    for (auto& [name, bytes] : report.entries)
+        os << name << ": " << bytes / 1024.0 / 1024.0 << " MB\n";
+    os << "Total tracked: " << report.total() / 1024.0 / 1024.0 << " MB\n";
+    os << "RSS: " << mem.rss / 1024.0 / 1024.0 << " MB, "
+       << mem.peak_rss / 1024.0 / 1024.0 << " MB peak\n";
+}
 
+#if defined(__APPLE__)
 inline void display_malloc_usage() {
     malloc_statistics_t stats;
     malloc_zone_statistics(nullptr, &stats);
@@ -26,17 +125,18 @@ inline void display_phys_footprint() {
                   << info.phys_footprint / 1024.0 / 1024.0 << " MB\n";
     }
 }
+#endif
 
-inline std::pair<double, double> mean_std_dev(vector<size_t>& nbrs){
-    size_t n = nbrs.size();
+inline std::pair<double, double> mean_std_dev(std::vector<std::size_t>& nbrs){
+    std::size_t n = nbrs.size();
     if (n == 0)
-        return pair<double, double>({0, 0});
+        return std::pair<double, double>({0, 0});
     double mean = std::accumulate(nbrs.begin(), nbrs.end(), 0.0)/n;
-    auto variance_fn = [&mean, &n](size_t acc, const size_t& val){
+    auto variance_fn = [&mean, &n](std::size_t acc, const std::size_t& val){
         return acc + ((val-mean)*(val-mean))/(n-1);
     };
     double variance = std::accumulate(nbrs.begin(), nbrs.end(), 0, variance_fn);
     return std::pair<double, double>(mean, std::sqrt(variance));
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <memory>
+#include <random>
 #include "../include/balltree.hpp"
 
 TEST(BallTreeTest, LeafInitialization) {
@@ -66,4 +67,32 @@ TEST(BallTreeTest, FarthestNeighbor) {
     const PlanarPoint* fn = tree->farthest(&query);
 
     EXPECT_EQ(fn, &pts[0]);
-}
\ No newline at end of file
+}
+TEST(BallTreeTest, BudgetedNearestNeighbor) {
+    using Pt = std::array<double, 4>;
+    L2Metric metric;
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> coord(0, 1);
+    vector<Pt> pts(500);
+    for(auto& p: pts)
+        for(auto& x: p)
+            x = coord(gen);
+    auto tree = greedy_tree(pts, metric);
+
+    for(size_t trial = 0; trial < 20; trial++){
+        Pt q{coord(gen), coord(gen), coord(gen), coord(gen)};
+        double best = std::numeric_limits<double>::max();
+        for(auto& p: pts)
+            best = std::min(best, metric.dist(p, q));
+        for(size_t max_evals: {1, 5, 20, 100}){
+            auto result = tree->nearest(&q, SearchBudget::evals(max_evals));
+            EXPECT_DOUBLE_EQ(result.dist, metric.dist(*result.nn, q));
+            EXPECT_LE(result.lower_bound, best + 1e-12);
+            EXPECT_GE(result.dist, best);
+        }
+        auto result = tree->nearest(&q, SearchBudget());
+        EXPECT_TRUE(result.complete);
+        EXPECT_DOUBLE_EQ(result.dist, best);
+        EXPECT_DOUBLE_EQ(result.ratio(), 1);
+    }
+}
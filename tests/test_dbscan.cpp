@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <map>
+#include "../include/dbscan.hpp"
+
+using Pt2 = std::array<double, 2>;
+
+// Fixture with dense blobs, a thin chain joining two of them, and scattered noise.
+class DbscanTest : public ::testing::Test {
+protected:
+    L2Metric metric;
+    GTPoints<2> G;
+    GTData aux;
+
+    void SetUp() override {
+        std::mt19937 gen(5);
+        std::normal_distribution<double> noise(0, 0.3);
+        std::uniform_real_distribution<double> coord(-10, 20);
+        std::vector<Pt2> pts;
+        for(Pt2 c: {Pt2{0, 0}, Pt2{5, 0}, Pt2{12, 8}})
+            for(size_t i = 0; i < 300; i++)
+                pts.push_back({c[0] + noise(gen), c[1] + noise(gen)});
+        for(size_t k = 0; k <= 50; k++)
+            pts.push_back({0.1 * k, 0});
+        for(size_t i = 0; i < 100; i++)
+            pts.push_back({coord(gen), coord(gen)});
+        auto tree = greedy_tree(pts, metric);
+        fast_gt(tree.get(), G, aux);
+    }
+
+    std::vector<bool> brute_core(double eps, size_t min_pts){
+        std::vector<bool> core(G.size());
+        for(size_t i = 0; i < G.size(); i++){
+            size_t count = 0;
+            for(size_t j = 0; j < G.size(); j++)
+                count += metric.dist(G[i].first, G[j].first) <= eps;
+            core[i] = count >= min_pts;
+        }
+        return core;
+    }
+};
+
+TEST_F(DbscanTest, MatchesBruteForce) {
+    double eps = 0.25;
+    size_t min_pts = 5;
+    std::vector<size_t> labels;
+    std::vector<bool> core;
+    size_t num_clusters = dbscan(G, aux, eps, min_pts, labels, core, metric);
+    auto expected_core = brute_core(eps, min_pts);
+    ASSERT_EQ(core, expected_core);
+
+    // core points share a label exactly when they are connected by core points within eps
+    DisjointSets<size_t> expected(G.size());
+    for(size_t i = 0; i < G.size(); i++)
+        for(size_t j = i + 1; j < G.size(); j++)
+            if(core[i] && core[j] && metric.dist(G[i].first, G[j].first) <= eps)
+                expected.unite(i, j);
+    std::map<size_t, size_t> label_of;
+    for(size_t i = 0; i < G.size(); i++){
+        if(!core[i])
+            continue;
+        ASSERT_LT(labels[i], num_clusters);
+        auto [it, added] = label_of.insert({expected.find(i), labels[i]});
+        EXPECT_EQ(it->second, labels[i]);
+    }
+    EXPECT_EQ(label_of.size(), num_clusters);
+
+    // the other points take the label of a core point within eps, or are noise
+    for(size_t i = 0; i < G.size(); i++){
+        if(core[i])
+            continue;
+        bool near_core = false, label_ok = false;
+        for(size_t j = 0; j < G.size(); j++){
+            if(core[j] && metric.dist(G[i].first, G[j].first) <= eps){
+                near_core = true;
+                label_ok |= labels[j] == labels[i];
+            }
+        }
+        if(near_core){
+            EXPECT_TRUE(label_ok);
+        }
+        else{
+            EXPECT_EQ(labels[i], dbscan_noise<size_t>);
+        }
+    }
+}
+
+TEST_F(DbscanTest, ChainAndApproximation) {
+    auto nearest = [&](Pt2 q){
+        size_t best = 0;
+        for(size_t i = 1; i < G.size(); i++)
+            if(metric.dist(G[i].first, q) < metric.dist(G[best].first, q))
+                best = i;
+        return best;
+    };
+    size_t left = nearest({0, 0}), right = nearest({5, 0}), far = nearest({12, 8});
+    std::vector<size_t> labels;
+    std::vector<bool> core;
+
+    // the chain joins the first two blobs once its spacing is within eps
+    dbscan(G, aux, 0.15, 3, labels, core, metric);
+    EXPECT_EQ(labels[left], labels[right]);
+    EXPECT_NE(labels[left], labels[far]);
+    dbscan(G, aux, 0.09, 3, labels, core, metric);
+    EXPECT_NE(labels[left], labels[right]);
+
+    // approximate neighborhoods only add neighbors
+    auto exact_core = brute_core(0.15, 3);
+    dbscan(G, aux, 0.15, 3, labels, core, metric, 0.5);
+    for(size_t i = 0; i < G.size(); i++)
+        if(exact_core[i]){
+            EXPECT_TRUE(core[i]);
+        }
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../include/emst.hpp"
+
+using Pt3 = std::array<double, 3>;
+
+std::vector<Pt3> clustered_points(size_t n, unsigned seed){
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> noise(0, 1);
+    std::uniform_real_distribution<double> coord(0, 50);
+    std::vector<Pt3> centers(8), pts(n);
+    for(auto& c: centers)
+        for(auto& x: c)
+            x = coord(gen);
+    for(size_t i = 0; i < n; i++)
+        for(size_t k = 0; k < 3; k++)
+            pts[i][k] = centers[i % centers.size()][k] + noise(gen);
+    return pts;
+}
+
+// Weight of the minimum spanning tree by Prim's algorithm on the complete graph.
+double prim_weight(const GTPoints<3>& G){
+    L2Metric metric;
+    size_t n = G.size();
+    std::vector<double> dist(n, std::numeric_limits<double>::max());
+    std::vector<bool> done(n, false);
+    double total = 0;
+    dist[0] = 0;
+    for(size_t step = 0; step < n; step++){
+        size_t u = n;
+        for(size_t i = 0; i < n; i++)
+            if(!done[i] && (u == n || dist[i] < dist[u]))
+                u = i;
+        done[u] = true;
+        total += dist[u];
+        for(size_t i = 0; i < n; i++)
+            if(!done[i])
+                dist[i] = std::min(dist[i], metric.dist(G[u].first, G[i].first));
+    }
+    return total;
+}
+
+void expect_spanning_tree(const GTPoints<3>& G, const std::vector<MSTEdge<size_t>>& edges){
+    L2Metric metric;
+    ASSERT_EQ(edges.size(), G.size() - 1);
+    DisjointSets<size_t> sets(G.size());
+    for(size_t k = 0; k < edges.size(); k++){
+        EXPECT_TRUE(sets.unite(edges[k].a, edges[k].b));
+        EXPECT_DOUBLE_EQ(edges[k].dist, metric.dist(G[edges[k].a].first, G[edges[k].b].first));
+        if(k > 0){
+            EXPECT_LE(edges[k - 1].dist, edges[k].dist);
+        }
+    }
+}
+
+TEST(EmstTest, MatchesPrim) {
+    L2Metric metric;
+    for(unsigned seed: {1, 2}){
+        auto pts = clustered_points(800, seed);
+        auto tree = greedy_tree(pts, metric);
+        GTPoints<3> G;
+        GTData aux;
+        fast_gt(tree.get(), G, aux);
+
+        std::vector<MSTEdge<size_t>> edges;
+        emst(G, aux, edges, metric);
+        expect_spanning_tree(G, edges);
+        double total = 0;
+        for(auto& e: edges)
+            total += e.dist;
+        EXPECT_NEAR(total, prim_weight(G), 1e-9 * total);
+    }
+}
+
+TEST(EmstTest, NodeStartsMarkFillers) {
+    L2Metric metric;
+    auto pts = clustered_points(300, 3);
+    auto tree = greedy_tree(pts, metric);
+    GTPoints<3> G;
+    GTData aux;
+    fast_gt(tree.get(), G, aux);
+
+    // emst skips the filler that ends every left chain, so it must not look like a node
+    auto start = node_starts(G, aux);
+    size_t fillers = 0;
+    for(size_t s = 0; s < aux.size(); s++){
+        if(start[s] == size_t(-1)){
+            fillers++;
+            EXPECT_EQ(aux[s], std::make_pair(0.0, size_t(1)));
+            EXPECT_EQ(aux[s - 1].second, 1u);
+        }
+        else
+            EXPECT_LE(start[s] + aux[s].second, G.size());
+    }
+    EXPECT_EQ(fillers, G.size());
+}
+
+TEST(EmstTest, DuplicatesAndFewPoints) {
+    L2Metric metric;
+    auto pts = clustered_points(100, 3);
+    pts.insert(pts.end(), pts.begin(), pts.begin() + 30);
+    auto tree = greedy_tree(pts, metric);
+    GTPoints<3> G;
+    GTData aux;
+    fast_gt(tree.get(), G, aux);
+
+    std::vector<MSTEdge<size_t>> edges;
+    emst(G, aux, edges, metric);
+    expect_spanning_tree(G, edges);
+    EXPECT_EQ(std::count_if(edges.begin(), edges.end(), [](auto& e){ return e.dist == 0; }), 30);
+
+    std::vector<Pt3> one({{1, 2, 3}});
+    tree = greedy_tree(one, metric);
+    fast_gt(tree.get(), G, aux);
+    emst(G, aux, edges, metric);
+    EXPECT_TRUE(edges.empty());
+}
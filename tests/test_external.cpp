@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <cstdio>
+#include "../include/greedy.hpp"
+#include "../include/external.hpp"
+
+template <std::size_t d, typename Scalar>
+void write_rows(const std::string& path, const std::vector<std::array<Scalar, d>>& rows){
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(rows.data()), rows.size() * sizeof(rows[0]));
+}
+
+template <std::size_t d, typename Scalar>
+std::vector<std::array<Scalar, d>> read_rows(const std::string& path){
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::vector<std::array<Scalar, d>> rows(in.tellg() / sizeof(std::array<Scalar, d>));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(rows.data()), rows.size() * sizeof(rows[0]));
+    return rows;
+}
+
+TEST(ExternalTest, MatchesInMemoryClarkson) {
+    using Pt = std::array<double, 3>;
+    L2Metric metric;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> coord(0, 100);
+
+    std::vector<Pt> pts(2000);
+    for(auto& p: pts)
+        for(auto& x: p)
+            x = coord(gen);
+
+    std::string input = ::testing::TempDir() + "ext_in.bin";
+    std::string output = ::testing::TempDir() + "ext_out.bin";
+    write_rows<3, double>(input, pts);
+
+    // tiny runs and budget so that spilling and compaction are exercised
+    ExternalConfig config;
+    config.scratch_path = ::testing::TempDir() + "ext_spill.bin";
+    config.run_length = 16;
+    config.resident_budget = 64;
+
+    std::vector<size_t> ext_pred, pred;
+    clarkson_external<3, double>(input, output, ext_pred, metric, config);
+    clarkson(pts, pred, metric);
+
+    EXPECT_EQ(ext_pred, pred);
+    EXPECT_EQ((read_rows<3, double>(output)), pts);
+
+    // with perm, each output row maps back to its input row
+    auto rows = read_rows<3, double>(input);
+    std::vector<size_t> perm;
+    clarkson_external<3, double>(input, output, perm, ext_pred, metric, config);
+    EXPECT_EQ(ext_pred, pred);
+    auto out_rows = read_rows<3, double>(output);
+    ASSERT_EQ(perm.size(), rows.size());
+    std::vector<size_t> sorted_perm(perm);
+    std::sort(sorted_perm.begin(), sorted_perm.end());
+    for(size_t i = 0; i < perm.size(); i++){
+        EXPECT_EQ(sorted_perm[i], i);
+        EXPECT_EQ(out_rows[i], rows[perm[i]]);
+    }
+
+    // 32-bit indices give the same answer
+    std::vector<std::uint32_t> perm32, pred32;
+    clarkson_external<3, double>(input, output, perm32, pred32, metric, config);
+    EXPECT_EQ(std::vector<size_t>(perm32.begin(), perm32.end()), perm);
+    EXPECT_EQ(std::vector<size_t>(pred32.begin() + 1, pred32.end()),
+              std::vector<size_t>(pred.begin() + 1, pred.end()));
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(ExternalTest, FloatInput) {
+    using FloatRow = std::array<float, 2>;
+    L1Metric metric;
+    std::vector<FloatRow> rows({{0, 0}, {1, 2}, {5, 6}, {15, 0}, {8, 5}});
+
+    std::string input = ::testing::TempDir() + "ext_float_in.bin";
+    std::string output = ::testing::TempDir() + "ext_float_out.bin";
+    write_rows<2, float>(input, rows);
+
+    ExternalConfig config;
+    config.scratch_path = ::testing::TempDir() + "ext_float_spill.bin";
+
+    std::vector<size_t> pred;
+    clarkson_external<2, float>(input, output, pred, metric, config);
+
+    std::vector<FloatRow> exp_gp({rows[0], rows[3], rows[4], rows[2], rows[1]});
+    EXPECT_EQ((read_rows<2, float>(output)), exp_gp);
+    EXPECT_EQ(pred, std::vector<size_t>({size_t(-1), 0, 1, 2, 0}));
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(ExternalTest, DuplicateRows) {
+    using Pt = std::array<double, 2>;
+    L2Metric metric;
+    std::mt19937 gen(8);
+    std::uniform_int_distribution<int> coord(0, 3);
+    std::vector<std::vector<Pt>> inputs({{{0, 0}, {0, 0}, {1, 1}, {1, 1}, {0, 0}}});
+    // many copies of a few distinct rows
+    inputs.emplace_back(300);
+    for(auto& p: inputs.back())
+        p = {double(coord(gen)), double(coord(gen))};
+
+    std::string input = ::testing::TempDir() + "ext_dup_in.bin";
+    std::string output = ::testing::TempDir() + "ext_dup_out.bin";
+    ExternalConfig config;
+    config.scratch_path = ::testing::TempDir() + "ext_dup_spill.bin";
+    config.run_length = 16;
+    config.resident_budget = 64;
+
+    for(auto& pts: inputs){
+        write_rows<2, double>(input, pts);
+        std::vector<size_t> pred;
+        clarkson_external<2, double>(input, output, pred, metric, config);
+        auto gp = read_rows<2, double>(output);
+
+        // a permutation of the input in which every point is as far from its
+        // predecessor as from any earlier point, and no farther than the one before
+        auto sorted = pts;
+        std::sort(sorted.begin(), sorted.end());
+        auto sorted_gp = gp;
+        std::sort(sorted_gp.begin(), sorted_gp.end());
+        ASSERT_EQ(sorted_gp, sorted);
+        double last = std::numeric_limits<double>::infinity();
+        for(size_t i = 1; i < gp.size(); i++){
+            ASSERT_LT(pred[i], i);
+            double r = metric.dist(gp[i], gp[pred[i]]);
+            for(size_t j = 0; j < i; j++)
+                EXPECT_LE(r, metric.dist(gp[i], gp[j]));
+            EXPECT_LE(r, last);
+            last = r;
+        }
+    }
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
@@ -27,6 +27,21 @@ struct GonzalezAlgo {
                     Metric metric) const {
         gonzalez(pts, pred, metric);
     }
+    template <std::size_t d, typename Metric>
+    void operator()(std::vector<std::array<double, d>>& pts,
+                    std::vector<size_t>& pred,
+                    std::vector<double>& radii,
+                    Metric metric) const {
+        gonzalez(pts, pred, radii, metric);
+    }
+    template <std::size_t d, typename Metric>
+    void operator()(const std::vector<std::array<double, d>>& pts,
+                    std::vector<size_t>& perm,
+                    std::vector<size_t>& pred,
+                    std::vector<double>& radii,
+                    Metric metric) const {
+        gonzalez(pts, perm, pred, radii, metric);
+    }
 };
 struct ClarksonAlgo {
     template <std::size_t d, typename Metric>
@@ -35,6 +50,21 @@ struct ClarksonAlgo {
                     Metric metric) const {
         clarkson(pts, pred, metric);
     }
+    template <std::size_t d, typename Metric>
+    void operator()(std::vector<std::array<double, d>>& pts,
+                    std::vector<size_t>& pred,
+                    std::vector<double>& radii,
+                    Metric metric) const {
+        clarkson(pts, pred, radii, metric);
+    }
+    template <std::size_t d, typename Metric>
+    void operator()(const std::vector<std::array<double, d>>& pts,
+                    std::vector<size_t>& perm,
+                    std::vector<size_t>& pred,
+                    std::vector<double>& radii,
+                    Metric metric) const {
+        clarkson(pts, perm, pred, radii, metric);
+    }
 };
 
 // Test fixture template
@@ -237,6 +267,58 @@ TYPED_TEST_P(GreedyTest, SpatialPointsPred) {
     EXPECT_EQ(pred, exp_pred);
 }
 
+TYPED_TEST_P(GreedyTest, NonDestructive) {
+    using SpatialPoint = std::array<double, 3>;
+    L2Metric metric;
+    TypeParam algo;
+    vector<SpatialPoint> pts;
+    pts.push_back(SpatialPoint({0, 0, 5}));
+    pts.push_back(SpatialPoint({1, 3, 3}));
+    pts.push_back(SpatialPoint({5, 6, 9}));
+    pts.push_back(SpatialPoint({15, 0, 10}));
+    pts.push_back(SpatialPoint({8, 5, 1}));
+    const vector<SpatialPoint> original = pts;
+
+    vector<size_t> perm, pred, exp_pred;
+    vector<double> radii;
+    algo(original, perm, pred, radii, metric);
+
+    // the in-place version defines the expected permutation
+    algo(pts, exp_pred, metric);
+    EXPECT_EQ(pred, exp_pred);
+    ASSERT_EQ(perm.size(), pts.size());
+    for(size_t i = 0; i < perm.size(); i++)
+        EXPECT_EQ(original[perm[i]], pts[i]);
+
+    EXPECT_EQ(radii[0], std::numeric_limits<double>::infinity());
+    for(size_t i = 1; i < perm.size(); i++)
+        EXPECT_DOUBLE_EQ(radii[i], metric.dist(pts[pred[i]], pts[i]));
+}
+
+TYPED_TEST_P(GreedyTest, InsertionRadii) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    TypeParam algo;
+    vector<PlanarPoint> pts;
+    for(size_t i = 0; i < 200; i++)
+        pts.push_back(PlanarPoint({double((i * 37) % 101), double((i * 53) % 89)}));
+    vector<PlanarPoint> expected_pts = pts;
+
+    vector<size_t> pred, exp_pred;
+    vector<double> radii;
+    algo(pts, pred, radii, metric);
+    algo(expected_pts, exp_pred, metric);
+    EXPECT_EQ(pts, expected_pts);
+    EXPECT_EQ(pred, exp_pred);
+
+    ASSERT_EQ(radii.size(), pts.size());
+    EXPECT_EQ(radii[0], std::numeric_limits<double>::infinity());
+    for(size_t i = 1; i < pts.size(); i++){
+        EXPECT_DOUBLE_EQ(radii[i], metric.dist(pts[pred[i]], pts[i]));
+        EXPECT_LE(radii[i], radii[i - 1]);
+    }
+}
+
 // Register all test cases
 REGISTER_TYPED_TEST_SUITE_P(
     GreedyTest,
@@ -249,9 +331,250 @@ REGISTER_TYPED_TEST_SUITE_P(
     PlanarPointsGP,
     PlanarPointsPred,
     SpatialPointsGP,
-    SpatialPointsPred
+    SpatialPointsPred,
+    NonDestructive,
+    InsertionRadii
 );
 
 // Instantiate with your algorithms
 typedef ::testing::Types<GonzalezAlgo, ClarksonAlgo> GreedyAlgos;
-INSTANTIATE_TYPED_TEST_SUITE_P(AllGreedyAlgos, GreedyTest, GreedyAlgos);
\ No newline at end of file
+INSTANTIATE_TYPED_TEST_SUITE_P(AllGreedyAlgos, GreedyTest, GreedyAlgos);
+TEST(GreedyCutTest, KCenterAndRNet) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    vector<PlanarPoint> pts;
+    for(size_t i = 0; i < 300; i++)
+        pts.push_back(PlanarPoint({double((i * 71) % 97), double((i * 29) % 83)}));
+    vector<size_t> pred;
+    vector<double> radii;
+    clarkson(pts, pred, radii, metric);
+
+    vector<size_t> labels, coarser;
+    for(size_t k: {1, 5, 40, 300}){
+        greedy_cut(pred, k, labels);
+        double cover = prefix_radius(radii, k);
+        for(size_t i = 0; i < pts.size(); i++){
+            ASSERT_LT(labels[i], k);
+            if(i < k){
+                EXPECT_EQ(labels[i], i);
+            }
+            // every point is within the covering radius of the prefix
+            double nearest = std::numeric_limits<double>::max();
+            for(size_t j = 0; j < k; j++)
+                nearest = std::min(nearest, metric.dist(pts[i], pts[j]));
+            EXPECT_LE(nearest, cover);
+            // the cut refines the previous one
+            if(!coarser.empty()){
+                EXPECT_EQ(coarser[labels[i]], coarser[i]);
+            }
+        }
+        coarser = labels;
+    }
+
+    // no cut is coarser than one cluster
+    greedy_cut(pred, 0, labels);
+    EXPECT_EQ(labels, vector<size_t>(pts.size(), 0));
+
+    // an r-net: prefix points are more than r apart and cover everything within r
+    double r = 10;
+    size_t k = greedy_cut(pred, radii, r, labels);
+    EXPECT_LE(prefix_radius(radii, k), r);
+    for(size_t i = 0; i < k; i++)
+        for(size_t j = i + 1; j < k; j++)
+            EXPECT_GT(metric.dist(pts[i], pts[j]), r);
+    EXPECT_EQ(greedy_prefix(radii, std::numeric_limits<double>::infinity()), 1);
+    EXPECT_EQ(greedy_prefix(radii, -1), pts.size());
+}
+
+TEST(NeighborGraphTest, RebalanceSkipsDistances) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    std::vector<PlanarPoint> pts;
+    for(int i = 0; i < 500; i++)
+        pts.push_back(PlanarPoint({std::sin(i * 1.7) * i, std::cos(i * 0.3) * 10.0}));
+    std::vector<PlanarPoint> gonzalez_pts = pts;
+    std::vector<size_t> gonzalez_pred;
+    gonzalez(gonzalez_pts, gonzalez_pred, metric);
+
+    NeighborGraph<2, L2Metric> G(pts, metric);
+    for(size_t i = 1; i < gonzalez_pts.size(); i++)
+        G.add_cell();
+    std::vector<PlanarPoint> output;
+    G.get_permutation(false, output);
+
+    // skipping evaluations must not change the greedy permutation
+    EXPECT_EQ(output, gonzalez_pts);
+    EXPECT_GT(G.num_skipped_evals(), 0);
+    EXPECT_GT(G.num_skipped_cells(), 0);
+}
+
+TEST(NeighborGraphTest, TooManyPointsForIdx) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    // 8-bit ids number at most 255 cells
+    std::vector<PlanarPoint> pts(255, PlanarPoint({0, 0}));
+    EXPECT_NO_THROW((NeighborGraph<2, L2Metric, PlanarPoint, CellHeap, std::uint8_t>(pts, metric)));
+    pts.assign(256, PlanarPoint({0, 0}));
+    EXPECT_THROW((NeighborGraph<2, L2Metric, PlanarPoint, CellHeap, std::uint8_t>(pts, metric)), std::length_error);
+}
+
+TEST(NeighborGraphTest, CellPointsFollowStoragePolicy) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    StoragePolicy saved = storage_policy();
+    storage_policy().huge_page_min_bytes = huge_page_bytes;
+
+    // the root cell copies the points into a block that starts on a huge page
+    std::vector<PlanarPoint> pts(huge_page_bytes / sizeof(PlanarPoint) + 2, PlanarPoint({1, 2}));
+    size_t n = pts.size();
+    NeighborGraph<2, L2Metric, PlanarPoint, CellHeap, std::uint32_t, CellAllocator<PlanarPoint>> G(pts, metric);
+    EXPECT_TRUE(pts.empty());
+    ASSERT_EQ(G.cells[0].size(), n - 1);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(G.cells[0].points.data()) % huge_page_bytes, 0u);
+    storage_policy() = saved;
+}
+
+TEST(CellHeapTest, UpdateKey) {
+    CellHeap heap;
+    heap.push(0, 5);
+    heap.push(1, 3);
+    heap.push(2, 4);
+    EXPECT_EQ(heap.top(), 0);
+    heap.update(0, 1);
+    EXPECT_EQ(heap.top(), 2);
+    heap.update(1, 4);
+    // equal radii are broken towards the larger index
+    EXPECT_EQ(heap.top(), 2);
+    heap.update(1, 6);
+    EXPECT_EQ(heap.top(), 1);
+    EXPECT_EQ(heap.size(), 3);
+}
+
+TEST(CellHeapTest, RelaxedClarkson) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    double eps = 0.5;
+    std::vector<PlanarPoint> pts;
+    for(int i = 0; i < 400; i++)
+        pts.push_back(PlanarPoint({std::sin(i * 1.7) * i, std::cos(i * 0.3) * 10.0}));
+    std::vector<PlanarPoint> input = pts;
+    std::vector<size_t> pred;
+    clarkson(pts, pred, metric, eps);
+
+    std::vector<PlanarPoint> sorted_in = input, sorted_out = pts;
+    std::sort(sorted_in.begin(), sorted_in.end());
+    std::sort(sorted_out.begin(), sorted_out.end());
+    ASSERT_EQ(sorted_out, sorted_in);
+
+    // each point is within a factor (1+eps) of the farthest from the prefix before it
+    std::vector<double> prefix_dist(pts.size(), std::numeric_limits<double>::max());
+    for(size_t i = 1; i < pts.size(); i++){
+        for(size_t k = i; k < pts.size(); k++)
+            prefix_dist[k] = std::min(prefix_dist[k], metric.dist(pts[i-1], pts[k]));
+        double far = *std::max_element(prefix_dist.begin() + i, prefix_dist.end());
+        EXPECT_GE(prefix_dist[i] * (1 + eps), far);
+        EXPECT_DOUBLE_EQ(metric.dist(pts[pred[i]], pts[i]), prefix_dist[i]);
+    }
+}
+
+template <typename Heap>
+void expect_empty_cells_last(Heap heap){
+    // cell 0 has points on its center only, cell 1 no points left
+    heap.push(0, 0);
+    heap.push(1, -1);
+    EXPECT_EQ(heap.top(), 0);
+    heap.push(2, 2);
+    EXPECT_EQ(heap.top(), 2);
+    heap.update(2, -1);
+    EXPECT_EQ(heap.top(), 0);
+    heap.update(0, -1);
+    heap.update(1, 0);
+    EXPECT_EQ(heap.top(), 1);
+}
+
+TEST(CellHeapTest, EmptyCellsLast) {
+    expect_empty_cells_last(CellHeap());
+    expect_empty_cells_last(RadiusBucketQueue(0.5));
+}
+
+TEST(CellHeapTest, DuplicatePoints) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    std::vector<PlanarPoint> input;
+    for(int i = 0; i < 50; i++)
+        for(int copy = 0; copy < 4; copy++)
+            input.push_back(PlanarPoint({double(i % 7), double(i / 7)}));
+
+    // cells whose points all coincide with the center have radius 0, like empty cells
+    for(double eps : {0.0, 0.5}){
+        std::vector<PlanarPoint> pts = input;
+        std::vector<size_t> pred;
+        if(eps > 0)
+            clarkson(pts, pred, metric, eps);
+        else
+            clarkson(pts, pred, metric);
+        ASSERT_EQ(pts.size(), input.size());
+        std::vector<PlanarPoint> sorted_in = input, sorted_out = pts;
+        std::sort(sorted_in.begin(), sorted_in.end());
+        std::sort(sorted_out.begin(), sorted_out.end());
+        EXPECT_EQ(sorted_out, sorted_in);
+        // the distinct points come first
+        for(size_t i = 1; i < 50; i++)
+            EXPECT_GT(metric.dist(pts[pred[i]], pts[i]), 0);
+        for(size_t i = 50; i < pts.size(); i++)
+            EXPECT_EQ(metric.dist(pts[pred[i]], pts[i]), 0);
+    }
+}
+
+TEST(AdjacencyTest, GrowAndPrune) {
+    ChunkedAdjacency<> adj;
+    for(size_t i = 0; i < 3; i++)
+        adj.add_vertex();
+    for(size_t j = 0; j < 20; j++){
+        adj.push_back(0, j);
+        adj.push_back(1, 100 + j);
+    }
+    adj.push_back(2, 7);
+    ASSERT_EQ(adj.degree(0), 20);
+    std::vector<size_t> first(adj[0].begin(), adj[0].end()), second(adj[1].begin(), adj[1].end());
+    for(size_t j = 0; j < 20; j++){
+        EXPECT_EQ(first[j], j);
+        EXPECT_EQ(second[j], 100 + j);
+    }
+    adj.remove_if(0, [](size_t j){ return j % 2 == 1; });
+    std::vector<size_t> evens(adj[0].begin(), adj[0].end());
+    EXPECT_EQ(evens, std::vector<size_t>({0, 2, 4, 6, 8, 10, 12, 14, 16, 18}));
+    EXPECT_EQ(std::vector<size_t>(adj[2].begin(), adj[2].end()), std::vector<size_t>({7}));
+}
+
+TEST(MemoryTest, NeighborGraphBreakdown) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    std::vector<PlanarPoint> pts;
+    for(int i = 0; i < 300; i++)
+        pts.push_back(PlanarPoint({std::sin(i * 1.7) * i, std::cos(i * 0.3) * 10.0}));
+    size_t n = pts.size();
+
+    NeighborGraph<2, L2Metric> G(pts, metric);
+    MemoryReport before;
+    G.memory_usage(before);
+    // the root cell holds every other point
+    EXPECT_GE(before.bytes("Cell::points"), (n - 1) * sizeof(PlanarPoint));
+    EXPECT_GE(before.bytes("Cell::distances"), (n - 1) * sizeof(double));
+
+    for(size_t i = 1; i < n; i++)
+        G.add_cell();
+    MemoryReport after;
+    G.memory_usage(after);
+    EXPECT_GE(after.bytes("cells"), n * sizeof(G.cells[0]));
+    EXPECT_GT(after.bytes("nbrs"), before.bytes("nbrs"));
+    EXPECT_GT(after.bytes("cell_heap"), before.bytes("cell_heap"));
+    EXPECT_EQ(after.total(), after.bytes("cells") + after.bytes("Cell::points") + after.bytes("Cell::distances")
+                            + after.bytes("nbrs") + after.bytes("cell_heap") + after.bytes("scratch"));
+
+#ifdef __linux__
+    ProcessMemory mem = process_memory();
+    EXPECT_GT(mem.rss, 0);
+    EXPECT_GE(mem.peak_rss, mem.rss);
+#endif
+}
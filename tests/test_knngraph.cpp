@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include "../include/knngraph.hpp"
+
+using Pt3 = std::array<double, 3>;
+
+std::vector<Pt3> random_points(size_t n, unsigned seed){
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> coord(0, 100);
+    std::vector<Pt3> pts(n);
+    for(auto& p: pts)
+        for(auto& x: p)
+            x = coord(gen);
+    return pts;
+}
+
+// Fraction of the lists of knn whose entries are no farther than the kth true neighbor.
+double knn_recall(const std::vector<Pt3>& pts, const KnnGraph<size_t>& knn, size_t k){
+    L2Metric metric;
+    size_t hits = 0;
+    for(size_t i = 0; i < pts.size(); i++){
+        std::vector<double> dists;
+        for(size_t j = 0; j < pts.size(); j++)
+            if(j != i)
+                dists.push_back(metric.dist(pts[i], pts[j]));
+        std::nth_element(dists.begin(), dists.begin() + k - 1, dists.end());
+        for(size_t a = knn.offsets[i]; a < knn.offsets[i + 1]; a++)
+            hits += knn.dists[a] <= dists[k - 1];
+    }
+    return double(hits) / (pts.size() * k);
+}
+
+void expect_valid(const std::vector<Pt3>& pts, const KnnGraph<size_t>& knn, size_t k){
+    L2Metric metric;
+    ASSERT_EQ(knn.num_points(), pts.size());
+    for(size_t i = 0; i < pts.size(); i++){
+        EXPECT_EQ(knn.degree(i), std::min(k, pts.size() - 1));
+        std::set<size_t> seen;
+        for(size_t a = knn.offsets[i]; a < knn.offsets[i + 1]; a++){
+            EXPECT_NE(knn.ids[a], i);
+            EXPECT_TRUE(seen.insert(knn.ids[a]).second);
+            EXPECT_DOUBLE_EQ(knn.dists[a], metric.dist(pts[i], pts[knn.ids[a]]));
+            if(a > knn.offsets[i]){
+                EXPECT_LE(knn.dists[a - 1], knn.dists[a]);
+            }
+        }
+    }
+}
+
+TEST(KnnGraphTest, InPlace) {
+    std::vector<Pt3> pts = random_points(1500, 3);
+    std::vector<Pt3> expected_pts = pts;
+    std::vector<size_t> pred, expected_pred;
+    KnnGraph<size_t> knn;
+    clarkson_knn(pts, pred, knn, 8, L2Metric());
+    clarkson(expected_pts, expected_pred, L2Metric());
+
+    // the permutation is that of clarkson and the ids are positions in it
+    EXPECT_EQ(pts, expected_pts);
+    EXPECT_EQ(pred, expected_pred);
+    expect_valid(pts, knn, 8);
+    EXPECT_GE(knn_recall(pts, knn, 8), 0.95);
+}
+
+TEST(KnnGraphTest, NonDestructive) {
+    const std::vector<Pt3> pts = random_points(1500, 4);
+    std::vector<size_t> perm, pred, expected_perm, expected_pred;
+    std::vector<double> radii;
+    KnnGraph<size_t> knn;
+    clarkson_knn(PtView<3>(pts), perm, pred, knn, 6, L2Metric());
+    clarkson(pts, expected_perm, expected_pred, radii, L2Metric());
+
+    // rows and ids index the input points
+    EXPECT_EQ(perm, expected_perm);
+    EXPECT_EQ(pred, expected_pred);
+    expect_valid(pts, knn, 6);
+    EXPECT_GE(knn_recall(pts, knn, 6), 0.95);
+}
+
+TEST(KnnGraphTest, FewPoints) {
+    std::vector<Pt3> one({{1, 2, 3}});
+    std::vector<size_t> pred;
+    KnnGraph<size_t> knn;
+    clarkson_knn(one, pred, knn, 4, L2Metric());
+    EXPECT_EQ(knn.num_points(), 1);
+    EXPECT_EQ(knn.degree(0), 0);
+
+    std::vector<Pt3> three({{0, 0, 0}, {1, 0, 0}, {5, 0, 0}});
+    clarkson_knn(three, pred, knn, 4, L2Metric());
+    expect_valid(three, knn, 4);
+}
+
+TEST(KnnGraphTest, HubReverseListsCapped) {
+    // point 0 is at distance 1 from all others, which are 2 apart, so every list holds 0
+    size_t n = 2000, k = 4;
+    size_t evals = 0;
+    auto dist = [&](size_t i, size_t j){
+        evals++;
+        return (i == 0 || j == 0) ? 1.0 : 2.0;
+    };
+    KnnLists<size_t> lists(n, k);
+    for(size_t i = 1; i < n; i++){
+        lists.insert(i, 0, 1);
+        lists.insert(0, i, 1);
+        size_t j = i % (n - 1) + 1;
+        lists.insert(i, j, 2);
+        lists.insert(j, i, 2);
+    }
+    refine_knn(lists, dist, 1);
+
+    // without a cap, every point would be offered the n - 1 reverse neighbors of the hub
+    EXPECT_LT(evals, 50 * n);
+    for(size_t i = 1; i < n; i++){
+        ASSERT_GE(lists.size(i), 1);
+        EXPECT_EQ(lists.id(i, 0), 0);
+    }
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include "../include/loaders.hpp"
+
+template <typename T>
+void write_vecs(const std::string& path, const std::vector<std::vector<T>>& rows){
+    std::ofstream out(path, std::ios::binary);
+    for(auto& row: rows){
+        std::int32_t dim = row.size();
+        out.write(reinterpret_cast<const char*>(&dim), sizeof(dim));
+        out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(T));
+    }
+}
+
+template <typename T>
+void write_bin(const std::string& path, const std::vector<std::vector<T>>& rows){
+    std::ofstream out(path, std::ios::binary);
+    std::uint32_t header[2] = {std::uint32_t(rows.size()), std::uint32_t(rows[0].size())};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for(auto& row: rows)
+        out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(T));
+}
+
+TEST(LoadersTest, PointFormats) {
+    std::vector<std::vector<float>> rows({{0.5f, 1, 2}, {3, 4, 5.25f}, {6, 7, 8}});
+    std::vector<std::vector<std::uint8_t>> bytes({{0, 1, 2}, {3, 4, 255}, {6, 7, 8}});
+    std::string fvecs = ::testing::TempDir() + "pts.fvecs";
+    std::string fbin = ::testing::TempDir() + "pts.fbin";
+    std::string bvecs = ::testing::TempDir() + "pts.bvecs";
+    std::string u8bin = ::testing::TempDir() + "pts.u8bin";
+    write_vecs(fvecs, rows);
+    write_bin(fbin, rows);
+    write_vecs(bvecs, bytes);
+    write_bin(u8bin, bytes);
+
+    using Pt = std::array<double, 3>;
+    std::vector<Pt> expected({{0.5, 1, 2}, {3, 4, 5.25}, {6, 7, 8}});
+    EXPECT_EQ(load_points<3>(fvecs), expected);
+    EXPECT_EQ(load_points<3>(fbin), expected);
+    EXPECT_EQ(load_points<3>(fbin, 2), std::vector<Pt>(expected.begin(), expected.begin() + 2));
+    EXPECT_EQ(load_points<3>(bvecs)[1], (Pt{3, 4, 255}));
+    EXPECT_EQ(load_points<3>(u8bin)[2], (Pt{6, 7, 8}));
+    EXPECT_EQ(vecs_dim(fvecs), 3);
+    EXPECT_EQ(vecs_size(u8bin), 3);
+
+    for(auto& path: {fvecs, fbin, bvecs, u8bin})
+        std::remove(path.c_str());
+}
+
+TEST(LoadersTest, GroundTruth) {
+    std::vector<std::vector<std::int32_t>> ids({{4, 2, 7}, {1, 0, 3}});
+    std::string ivecs = ::testing::TempDir() + "gt.ivecs";
+    std::string ibin = ::testing::TempDir() + "gt.ibin";
+    write_vecs(ivecs, ids);
+    write_bin(ibin, ids);
+    // ibin ground truth is followed by the distances, which are ignored
+    {
+        std::ofstream out(ibin, std::ios::binary | std::ios::app);
+        std::vector<float> dists(6, 1.0f);
+        out.write(reinterpret_cast<const char*>(dists.data()), dists.size() * sizeof(float));
+    }
+
+    using Ids = std::vector<std::vector<std::uint32_t>>;
+    EXPECT_EQ(load_neighbors(ivecs), (Ids{{4, 2, 7}, {1, 0, 3}}));
+    EXPECT_EQ(load_neighbors(ibin, 2), (Ids{{4, 2}, {1, 0}}));
+    EXPECT_EQ(load_neighbors(ibin, 1, 1), (Ids{{4}}));
+
+    std::remove(ivecs.c_str());
+    std::remove(ibin.c_str());
+}
+
+TEST(LoadersTest, RejectsMismatchedFiles) {
+    std::vector<std::vector<float>> rows({{1, 2}, {3, 4}});
+    std::string fvecs = ::testing::TempDir() + "bad.fvecs";
+    std::string fbin = ::testing::TempDir() + "bad.fbin";
+    write_vecs(fvecs, rows);
+    write_bin(fbin, rows);
+
+    // wrong dimension, wrong content, unknown extension, missing file
+    EXPECT_THROW(load_points<3>(fvecs), std::runtime_error);
+    EXPECT_THROW(load_neighbors(fvecs), std::runtime_error);
+    EXPECT_THROW(load_points<2>(::testing::TempDir() + "pts.txt"), std::runtime_error);
+    EXPECT_THROW(load_points<2>(::testing::TempDir() + "missing.fvecs"), std::runtime_error);
+
+    // a truncated file
+    {
+        std::ofstream out(fvecs, std::ios::binary | std::ios::app);
+        out.put(0);
+    }
+    EXPECT_THROW(load_points<2>(fvecs), std::runtime_error);
+    // a header promising more rows than the file holds
+    {
+        std::fstream out(fbin, std::ios::binary | std::ios::in | std::ios::out);
+        std::uint32_t n = 5;
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+    EXPECT_THROW(load_points<2>(fbin), std::runtime_error);
+
+    std::remove(fvecs.c_str());
+    std::remove(fbin.c_str());
+}
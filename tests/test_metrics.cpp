@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <bitset>
+#include <random>
+#include <algorithm>
+#include "../include/fast_search_impl.hpp"
+
+template <std::size_t bits>
+std::vector<BitPoint<bits>> random_codes(std::size_t n, unsigned seed){
+    std::mt19937_64 gen(seed);
+    std::vector<BitPoint<bits>> codes(n);
+    for(auto& c: codes)
+        for(auto& w: c)
+            w = gen();
+    return codes;
+}
+
+template <std::size_t bits>
+double naive_hamming(const BitPoint<bits>& a, const BitPoint<bits>& b){
+    double sum = 0;
+    for(std::size_t i = 0; i < a.size(); i++)
+        sum += std::bitset<64>(a[i] ^ b[i]).count();
+    return sum;
+}
+
+TEST(HammingMetricTest, MatchesNaivePopcount) {
+    HammingMetric metric;
+    auto codes = random_codes<512>(20, 1);
+    auto short_codes = random_codes<192>(20, 2);
+    for(std::size_t i = 0; i < codes.size(); i++)
+        for(std::size_t j = 0; j < codes.size(); j++){
+            EXPECT_EQ(metric.dist(codes[i], codes[j]), naive_hamming<512>(codes[i], codes[j]));
+            EXPECT_EQ(metric.dist(short_codes[i], short_codes[j]), naive_hamming<192>(short_codes[i], short_codes[j]));
+        }
+    EXPECT_EQ(metric.dist(codes[0], codes[0]), 0);
+
+    // bounded counts are exact within the limit and exceed it otherwise
+    for(std::size_t i = 1; i < codes.size(); i++){
+        double exact = metric.dist(codes[0], codes[i]);
+        double short_exact = metric.dist(short_codes[0], short_codes[i]);
+        EXPECT_EQ(metric.compare_dist_bounded(codes[0], codes[i], exact), exact);
+        EXPECT_EQ(metric.dist_bounded(short_codes[0], short_codes[i], short_exact), short_exact);
+        EXPECT_GT(metric.compare_dist_bounded(codes[0], codes[i], exact / 4), exact / 4);
+        EXPECT_LT(metric.compare_dist_bounded(codes[0], codes[i], exact / 4), exact);
+        EXPECT_GT(metric.dist_bounded(short_codes[0], short_codes[i], short_exact - 1), short_exact - 1);
+    }
+}
+
+TEST(HammingMetricTest, GreedyTreeSearch) {
+    using Code = BitPoint<256>;
+    HammingMetric metric;
+    auto pts = random_codes<256>(300, 3);
+    auto queries = random_codes<256>(20, 4);
+
+    auto tree = greedy_tree(pts, metric);
+    EXPECT_EQ(tree->size, pts.size());
+
+    GTPoints<4, Code> G;
+    GTData aux;
+    fast_gt(tree.get(), G, aux);
+    ASSERT_EQ(G.size(), pts.size());
+
+    ApxNNSearch<4, HammingMetric, Code> nn_search(G, aux, metric);
+    ApxRngSearch<4, HammingMetric, Code> rng_search(G, aux, metric);
+    for(auto& q: queries){
+        double nn_dist = metric.dist(q, pts[0]);
+        for(auto& p: pts)
+            nn_dist = std::min(nn_dist, metric.dist(q, p));
+        EXPECT_EQ(metric.dist(q, G[nn_search(q)].first), nn_dist);
+
+        double rad = nn_dist + 8;
+        std::vector<size_t> found, expected;
+        rng_search(q, rad, found);
+        for(size_t i = 0; i < G.size(); i++)
+            if(metric.dist(q, G[i].first) <= rad)
+                expected.push_back(i);
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+    }
+}
+
+TEST(HammingMetricTest, ClarksonIsGreedy) {
+    HammingMetric metric;
+    auto pts = random_codes<256>(200, 5);
+    std::vector<size_t> pred;
+    clarkson(pts, pred, metric);
+
+    // each point is at the largest distance from the prefix before it, and pred is its nearest point there
+    std::vector<double> prefix_dist(pts.size(), std::numeric_limits<double>::max());
+    for(size_t i = 1; i < pts.size(); i++){
+        for(size_t k = i; k < pts.size(); k++)
+            prefix_dist[k] = std::min(prefix_dist[k], metric.dist(pts[i-1], pts[k]));
+        double far = *std::max_element(prefix_dist.begin() + i, prefix_dist.end());
+        EXPECT_EQ(prefix_dist[i], far);
+        EXPECT_EQ(metric.dist(pts[pred[i]], pts[i]), prefix_dist[i]);
+    }
+}
+
+TEST(AngularMetricTest, MatchesNaiveAngle) {
+    using Pt = std::array<double, 3>;
+    AngularMetric metric;
+    NormedPoint<3> x(Pt({1, 0, 0})), y(Pt({0, 2, 0})), xy(Pt({3, 3, 0})), neg_x(Pt({-5, 0, 0}));
+    NormedPoint<3> zero(Pt({0, 0, 0}));
+
+    EXPECT_DOUBLE_EQ(x.norm, 1);
+    EXPECT_DOUBLE_EQ(xy.norm, std::sqrt(18.0));
+    EXPECT_DOUBLE_EQ(metric.dist(x, y), M_PI / 2);
+    EXPECT_DOUBLE_EQ(metric.dist(x, xy), M_PI / 4);
+    EXPECT_DOUBLE_EQ(metric.dist(x, neg_x), M_PI);
+    EXPECT_DOUBLE_EQ(metric.dist(x, x), 0);
+    EXPECT_DOUBLE_EQ(metric.dist(zero, y), M_PI / 2);
+    EXPECT_DOUBLE_EQ(metric.dist(zero, zero), 0);
+    EXPECT_LT(metric.compare_dist(x, xy), metric.compare_dist(x, y));
+
+    // small angles keep their relative precision
+    for(double angle: {1e-3, 1e-6, 1e-9}){
+        NormedPoint<3> p(Pt({std::cos(angle), std::sin(angle), 0}));
+        EXPECT_NEAR(metric.dist(x, p), angle, angle * 1e-9);
+    }
+
+    // radii beyond pi do not wrap around
+    EXPECT_DOUBLE_EQ(metric.to_compare_dist(3 * M_PI / 2), 2);
+    EXPECT_DOUBLE_EQ(metric.to_compare_dist(-1), 0);
+}
+
+TEST(AngularMetricTest, GreedyTreeSearch) {
+    using Pt = std::array<double, 8>;
+    using NPt = NormedPoint<8>;
+    AngularMetric metric;
+    std::mt19937 gen(11);
+    std::normal_distribution<double> coord;
+    auto random_pt = [&](){
+        Pt p;
+        for(auto& x: p)
+            x = coord(gen);
+        return NPt(p);
+    };
+
+    std::vector<NPt> pts;
+    for(int i = 0; i < 300; i++)
+        pts.push_back(random_pt());
+    auto tree = greedy_tree(pts, metric);
+
+    GTPoints<8, NPt> G;
+    GTData aux;
+    fast_gt(tree.get(), G, aux);
+    ApxNNSearch<8, AngularMetric, NPt> nn_search(G, aux, metric);
+
+    for(int k = 0; k < 20; k++){
+        NPt q = random_pt();
+        double nn_dist = M_PI;
+        for(auto& p: pts)
+            nn_dist = std::min(nn_dist, metric.dist(q, p));
+        EXPECT_DOUBLE_EQ(metric.dist(q, G[nn_search(q)].first), nn_dist);
+    }
+}
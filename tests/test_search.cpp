@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <algorithm>
+#include "../include/fast_search_impl.hpp"
+#include "../include/packed_gt.hpp"
+
+template <std::size_t d>
+std::vector<std::array<double, d>> random_points(std::size_t n, unsigned seed){
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> coord(0, 1);
+    std::vector<std::array<double, d>> pts(n);
+    for(auto& p: pts)
+        for(auto& x: p)
+            x = coord(gen);
+    return pts;
+}
+
+// Fixture with a 40-dimensional greedy tree, so that bounded distances stop early.
+class SearchTest : public ::testing::Test {
+protected:
+    static constexpr std::size_t d = 40;
+    using Pt = std::array<double, d>;
+    L2Metric metric;
+    std::vector<Pt> pts, queries;
+    GTPoints<d> G, Q;
+    GTData aux, q_aux;
+
+    void SetUp() override {
+        pts = random_points<d>(400, 1);
+        queries = random_points<d>(50, 2);
+        auto tree = greedy_tree(pts, metric);
+        fast_gt(tree.get(), G, aux);
+        auto q_tree = greedy_tree(queries, metric);
+        fast_gt(q_tree.get(), Q, q_aux);
+    }
+
+    double nn_dist(const Pt& q){
+        double best = std::numeric_limits<double>::max();
+        for(auto& [p, p_aux]: G)
+            best = std::min(best, metric.dist(p, q));
+        return best;
+    }
+
+    std::vector<size_t> in_range(const Pt& q, double rad){
+        std::vector<size_t> output;
+        for(size_t i = 0; i < G.size(); i++)
+            if(metric.dist(G[i].first, q) <= rad)
+                output.push_back(i);
+        return output;
+    }
+};
+
+TEST_F(SearchTest, BoundedDistance) {
+    for(size_t i = 1; i < pts.size(); i++){
+        double exact = metric.compare_dist(pts[0], pts[i]);
+        EXPECT_EQ(metric.compare_dist_bounded(pts[0], pts[i], exact), exact);
+        EXPECT_GT(metric.compare_dist_bounded(pts[0], pts[i], exact / 2), exact / 2);
+        EXPECT_EQ(metric.dist_bounded(pts[0], pts[i], std::sqrt(exact)), metric.dist(pts[0], pts[i]));
+    }
+}
+
+TEST_F(SearchTest, SingleNearestNeighbor) {
+    ApxNNSearch<d, L2Metric> search(G, aux, metric);
+    for(auto& q: queries)
+        EXPECT_DOUBLE_EQ(metric.dist(G[search(q)].first, q), nn_dist(q));
+}
+
+TEST_F(SearchTest, SingleApproximateNearestNeighbor) {
+    ApxNNSearch<d, L2Metric> search(G, aux, metric);
+    for(double e: {0.1, 0.5, 2.0})
+        for(auto& q: queries)
+            EXPECT_LE(metric.dist(G[search(q, e)].first, q), (1 + e) * nn_dist(q) + 1e-12);
+}
+
+TEST_F(SearchTest, BudgetedNearestNeighbor) {
+    ApxNNSearch<d, L2Metric> search(G, aux, metric);
+    for(auto& q: queries){
+        double best = nn_dist(q);
+        for(size_t max_evals: {1, 10, 100}){
+            auto result = search.nearest(q, SearchBudget::evals(max_evals));
+            EXPECT_DOUBLE_EQ(result.dist, metric.dist(G[result.nn].first, q));
+            EXPECT_LE(result.lower_bound, best + 1e-12);
+            EXPECT_GE(result.dist, best);
+        }
+        auto result = search.nearest(q, SearchBudget());
+        EXPECT_TRUE(result.complete);
+        EXPECT_DOUBLE_EQ(result.dist, best);
+    }
+}
+
+TEST_F(SearchTest, WarmStartedNearestNeighbor) {
+    ApxNNSearch<d, L2Metric> search(G, aux, metric);
+    // a walk of small steps from each query, searched as one stream
+    std::mt19937 gen(4);
+    std::normal_distribution<double> step(0, 0.01);
+    WarmStart<Pt> warm;
+    for(auto q: queries){
+        EXPECT_DOUBLE_EQ(search.nearest(q, search(q)).dist, nn_dist(q));
+        EXPECT_DOUBLE_EQ(search.nearest(q, G.size() - 1).dist, nn_dist(q));
+        for(size_t t = 0; t < 5; t++){
+            for(auto& x: q)
+                x += step(gen);
+            auto result = search.nearest(q, warm);
+            EXPECT_TRUE(result.complete);
+            EXPECT_DOUBLE_EQ(result.dist, nn_dist(q));
+            EXPECT_EQ(warm.nn, result.nn);
+        }
+    }
+}
+
+TEST_F(SearchTest, BudgetedRange) {
+    ApxRngSearch<d, L2Metric> search(G, aux, metric);
+    double rad = 2.2;
+    for(auto& q: queries){
+        SearchRangeVec ranges;
+        size_t settled = search(q, rad, ranges, SearchBudget::evals(20));
+        std::vector<bool> found(G.size());
+        for(auto [j, n_j]: ranges)
+            for(size_t k = j; k < j + n_j; k++){
+                EXPECT_LT(k, settled);
+                EXPECT_LE(metric.dist(G[k].first, q), rad);
+                found[k] = true;
+            }
+        for(size_t k = 0; k < settled; k++)
+            EXPECT_EQ(found[k], metric.dist(G[k].first, q) <= rad);
+        EXPECT_EQ(search(q, rad, ranges, SearchBudget()), G.size());
+    }
+}
+
+TEST_F(SearchTest, BatchNearestNeighbor) {
+    ApxNNSearch<d, L2Metric> search(G, aux, metric);
+    std::vector<size_t> output;
+    search(Q, q_aux, output);
+    ASSERT_EQ(output.size(), Q.size());
+    for(size_t i = 0; i < Q.size(); i++)
+        EXPECT_DOUBLE_EQ(metric.dist(G[output[i]].first, Q[i].first), nn_dist(Q[i].first));
+}
+
+TEST_F(SearchTest, SingleRange) {
+    ApxRngSearch<d, L2Metric> search(G, aux, metric);
+    double rad = 2.2;
+    for(auto& q: queries){
+        std::vector<size_t> output;
+        search(q, rad, output);
+        std::sort(output.begin(), output.end());
+        EXPECT_EQ(output, in_range(q, rad));
+    }
+}
+
+TEST_F(SearchTest, BatchRange) {
+    ApxRngSearch<d, L2Metric> search(G, aux, metric);
+    double rad = 2.2;
+    std::vector<std::vector<size_t>> output;
+    search(Q, q_aux, rad, output);
+    ASSERT_EQ(output.size(), Q.size());
+    for(size_t i = 0; i < Q.size(); i++){
+        std::sort(output[i].begin(), output[i].end());
+        EXPECT_EQ(output[i], in_range(Q[i].first, rad));
+    }
+}
+
+TEST_F(SearchTest, SelfJoin) {
+    ApxRngSearch<d, L2Metric> search(G, aux, metric);
+    double rad = 1.5;
+    for(bool include_self: {false, true}){
+        std::vector<std::vector<size_t>> output;
+        search.self_join(rad, output, 0, include_self);
+        ASSERT_EQ(output.size(), G.size());
+
+        // each unordered pair is reported once, on either side
+        std::vector<std::vector<size_t>> pairs(G.size());
+        for(size_t i = 0; i < G.size(); i++)
+            for(size_t j: output[i])
+                pairs[std::min(i, j)].push_back(std::max(i, j));
+        for(size_t i = 0; i < G.size(); i++){
+            std::sort(pairs[i].begin(), pairs[i].end());
+            std::vector<size_t> expected;
+            for(size_t j: in_range(G[i].first, rad))
+                if(j > i || (include_self && j == i))
+                    expected.push_back(j);
+            EXPECT_EQ(pairs[i], expected);
+        }
+    }
+}
+
+TEST_F(SearchTest, Uint32Index) {
+    using Idx = std::uint32_t;
+    GTPoints<d, Pt, Idx> G32, Q32;
+    GTDataT<Idx> aux32, q_aux32;
+    auto tree = greedy_tree<Idx>(pts, metric);
+    fast_gt(tree.get(), G32, aux32);
+    auto q_tree = greedy_tree<Idx>(queries, metric);
+    fast_gt(q_tree.get(), Q32, q_aux32);
+    ASSERT_EQ(G32.size(), G.size());
+    for(size_t i = 0; i < G.size(); i++)
+        EXPECT_EQ(G32[i].first, G[i].first);
+
+    ApxNNSearch<d, L2Metric, Pt, Idx> nn_search(G32, aux32, metric);
+    std::vector<Idx> nn;
+    nn_search(Q32, q_aux32, nn);
+    for(size_t i = 0; i < Q32.size(); i++){
+        EXPECT_DOUBLE_EQ(metric.dist(G32[nn[i]].first, Q32[i].first), nn_dist(Q32[i].first));
+        EXPECT_DOUBLE_EQ(metric.dist(G32[nn_search(Q32[i].first)].first, Q32[i].first), nn_dist(Q32[i].first));
+    }
+
+    ApxRngSearch<d, L2Metric, Pt, Idx> rng_search(G32, aux32, metric);
+    double rad = 2.2;
+    for(auto& q: queries){
+        std::vector<Idx> found;
+        rng_search(q, rad, found);
+        std::sort(found.begin(), found.end());
+        auto expected = in_range(q, rad);
+        EXPECT_EQ(std::vector<size_t>(found.begin(), found.end()), expected);
+    }
+}
+
+TEST_F(SearchTest, PackedLayout) {
+    PackedGT<Pt> packed;
+    pack_gt(G, aux, packed);
+    ASSERT_EQ(packed.nodes.size(), G.size());
+    for(size_t i = 0; i < G.size(); i++){
+        auto& node = packed.nodes[i];
+        EXPECT_EQ(node.center, G[i].first);
+        EXPECT_GE(node.rad, aux[G[i].second].first);
+        EXPECT_EQ(node.size, aux[G[i].second].second);
+    }
+
+    PackedNNSearch<d, L2Metric> search(packed, metric);
+    for(auto& q: queries){
+        EXPECT_DOUBLE_EQ(metric.dist(G[search(q)].first, q), nn_dist(q));
+        EXPECT_LE(metric.dist(G[search(q, 0.5)].first, q), 1.5 * nn_dist(q) + 1e-12);
+    }
+}
+
+TEST_F(SearchTest, MemoryUsage) {
+    MemoryReport report;
+    memory_usage(G, aux, report);
+    EXPECT_EQ(report.bytes("GTPoints"), G.capacity() * sizeof(G[0]));
+    EXPECT_EQ(report.bytes("GTData"), aux.capacity() * sizeof(aux[0]));
+    // fast_gt reserves exactly what it writes
+    EXPECT_EQ(aux.size(), 3 * G.size() - 1);
+    EXPECT_EQ(aux.capacity(), aux.size());
+    EXPECT_EQ(G.capacity(), G.size());
+
+    auto tree = greedy_tree(pts, metric);
+    memory_usage(tree.get(), report);
+    EXPECT_EQ(report.bytes("BallTree nodes"), (2 * pts.size() - 1) * sizeof(*tree));
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../include/setdist.hpp"
+
+using Pt3 = std::array<double, 3>;
+
+// Fixture with two overlapping clouds of different sizes and their fast_gt layouts.
+class SetDistTest : public ::testing::Test {
+protected:
+    L2Metric metric;
+    std::vector<Pt3> a_pts, b_pts;
+    GTPoints<3> A, B;
+    GTData aux_a, aux_b;
+
+    static std::vector<Pt3> cloud(size_t n, double offset, unsigned seed){
+        std::mt19937 gen(seed);
+        std::normal_distribution<double> coord(0, 1);
+        std::vector<Pt3> pts(n);
+        for(auto& p: pts)
+            for(auto& x: p)
+                x = coord(gen) + offset;
+        return pts;
+    }
+
+    void SetUp() override {
+        a_pts = cloud(700, 0, 1);
+        b_pts = cloud(500, 0.5, 2);
+        auto a_tree = greedy_tree(a_pts, metric);
+        fast_gt(a_tree.get(), A, aux_a);
+        auto b_tree = greedy_tree(b_pts, metric);
+        fast_gt(b_tree.get(), B, aux_b);
+    }
+
+    double brute_directed(const GTPoints<3>& X, const GTPoints<3>& Y){
+        double h = 0;
+        for(auto& [x, x_aux]: X){
+            double nn = std::numeric_limits<double>::max();
+            for(auto& [y, y_aux]: Y)
+                nn = std::min(nn, metric.dist(x, y));
+            h = std::max(h, nn);
+        }
+        return h;
+    }
+
+    double brute_closest(){
+        double best = std::numeric_limits<double>::max();
+        for(auto& [x, x_aux]: A)
+            for(auto& [y, y_aux]: B)
+                best = std::min(best, metric.dist(x, y));
+        return best;
+    }
+};
+
+TEST_F(SetDistTest, Hausdorff) {
+    double ab = brute_directed(A, B), ba = brute_directed(B, A);
+    EXPECT_DOUBLE_EQ(directed_hausdorff(A, aux_a, B, aux_b, metric), ab);
+    EXPECT_DOUBLE_EQ(directed_hausdorff(B, aux_b, A, aux_a, metric), ba);
+    EXPECT_DOUBLE_EQ(hausdorff(A, aux_a, B, aux_b, metric), std::max(ab, ba));
+    EXPECT_DOUBLE_EQ(hausdorff(A, aux_a, A, aux_a, metric), 0);
+
+    for(double e: {0.1, 0.5}){
+        double h = hausdorff(A, aux_a, B, aux_b, metric, e);
+        EXPECT_LE(h, std::max(ab, ba));
+        EXPECT_GE(h * (1 + e), std::max(ab, ba));
+    }
+}
+
+TEST_F(SetDistTest, ClosestPair) {
+    double expected = brute_closest();
+    auto pair = closest_pair(A, aux_a, B, aux_b, metric);
+    EXPECT_DOUBLE_EQ(pair.dist, expected);
+    EXPECT_DOUBLE_EQ(metric.dist(A[pair.a].first, B[pair.b].first), pair.dist);
+
+    auto apx = closest_pair(A, aux_a, B, aux_b, metric, 0.5);
+    EXPECT_DOUBLE_EQ(metric.dist(A[apx.a].first, B[apx.b].first), apx.dist);
+    EXPECT_LE(apx.dist, 1.5 * expected);
+}
+
+TEST_F(SetDistTest, EmptySets) {
+    GTPoints<3> E;
+    GTData aux_e;
+    EXPECT_EQ(directed_hausdorff(E, aux_e, B, aux_b, metric), 0);
+    EXPECT_EQ(directed_hausdorff(A, aux_a, E, aux_e, metric), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(hausdorff(A, aux_a, E, aux_e, metric), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(closest_pair(E, aux_e, B, aux_b, metric).dist, std::numeric_limits<double>::infinity());
+}
@@ -0,0 +1,56 @@
+// Built as a separate executable with STAT defined (see CMakelists.txt)
+#include <gtest/gtest.h>
+#include "../include/greedy.hpp"
+#include <vector>
+#include <cmath>
+
+TEST(BuildStatsTest, CountsClarksonBuild) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    std::vector<PlanarPoint> pts;
+    for(int i = 0; i < 500; i++)
+        pts.push_back(PlanarPoint({std::sin(i * 1.7) * i, std::cos(i * 0.3) * 10.0}));
+
+    build_stats().reset();
+    std::vector<size_t> pred;
+    clarkson(pts, pred, metric);
+    BuildStats& stats = build_stats();
+
+    EXPECT_GT(stats.count(Counter::dist_evals), 0);
+    EXPECT_GT(stats.count(Counter::points_moved), 0);
+    EXPECT_GT(stats.count(Counter::evals_skipped), 0);
+    EXPECT_GT(stats.count(Counter::cells_skipped), 0);
+    EXPECT_EQ(stats.count(Counter::heap_skips), 0);
+    EXPECT_GT(stats.count(Counter::edges_added), 0);
+    EXPECT_GT(stats.count(Counter::edges_pruned), 0);
+    EXPECT_GT(stats.seconds(Phase::point_location), 0);
+
+    // samples at 2, 4, ..., 256 cells and one for the final graph
+    auto& samples = stats.degree_samples();
+    ASSERT_EQ(samples.size(), 9);
+    EXPECT_EQ(samples.front().num_cells, 2);
+    EXPECT_EQ(samples.back().num_cells, pts.size());
+    size_t total = 0;
+    for(size_t c: samples.back().hist)
+        total += c;
+    EXPECT_EQ(total, pts.size());
+    EXPECT_LE(samples.back().mean, samples.back().max);
+
+    std::string json = stats.json();
+    EXPECT_NE(json.find("\"dist_evals\": "), std::string::npos);
+    EXPECT_NE(json.find("\"phase_seconds\": {"), std::string::npos);
+    EXPECT_NE(json.find("\"degree_samples\": [{\"num_cells\": 2"), std::string::npos);
+}
+
+TEST(BuildStatsTest, RelaxedQueueSkipsBuckets) {
+    using PlanarPoint = std::array<double, 2>;
+    L2Metric metric;
+    std::vector<PlanarPoint> pts;
+    for(int i = 0; i < 300; i++)
+        pts.push_back(PlanarPoint({std::sin(i * 1.7) * i, std::cos(i * 0.3) * 10.0}));
+
+    build_stats().reset();
+    std::vector<size_t> pred;
+    clarkson(pts, pred, metric, 0.1);
+    EXPECT_GT(build_stats().count(Counter::heap_skips), 0);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../include/fast_search_impl.hpp"
+#include "../include/storage.hpp"
+
+TEST(StorageTest, AlignedRows) {
+    EXPECT_EQ(sizeof(AlignedPoint<2>), cache_line_bytes);
+    EXPECT_EQ(sizeof(AlignedPoint<3>), cache_line_bytes);
+    EXPECT_EQ(sizeof(AlignedPoint<3, row_alignment(24)>), 32u);
+    EXPECT_EQ(alignof(AlignedPoint<8>), cache_line_bytes);
+    EXPECT_EQ(sizeof(AlignedPoint<10>), 2 * cache_line_bytes);
+    // the aux index of a GTPoints entry goes in the padding of the row when there is room
+    EXPECT_EQ(sizeof(GTPoints<3, AlignedPoint<3>>::value_type), cache_line_bytes);
+    EXPECT_EQ(sizeof(GTPoints<7, AlignedPoint<7>>::value_type), cache_line_bytes);
+    EXPECT_EQ(sizeof(GTPoints<8, AlignedPoint<8>>::value_type), 2 * cache_line_bytes);
+
+    std::vector<AlignedPoint<3>> pts(100);
+    for(auto& p: pts)
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p.data()) % cache_line_bytes, 0u);
+    GTPoints<3, AlignedPoint<3>> G(100);
+    for(auto& [p, s]: G)
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p.data()) % cache_line_bytes, 0u);
+}
+
+TEST(StorageTest, HugePageAllocator) {
+    std::vector<double, HugePageAllocator<double>> small(10, 1.0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(small.data()) % cache_line_bytes, 0u);
+
+    // blocks at least as large as the policy threshold start on a huge page
+    StoragePolicy saved = storage_policy();
+    storage_policy().huge_page_min_bytes = huge_page_bytes;
+    std::vector<double, HugePageAllocator<double>> large(huge_page_bytes / sizeof(double) + 1, 2.0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(large.data()) % huge_page_bytes, 0u);
+    EXPECT_EQ(large.back(), 2.0);
+    storage_policy() = saved;
+}
+
+TEST(StorageTest, GreedyTreeOfAlignedPoints) {
+    std::mt19937 gen(6);
+    std::uniform_real_distribution<double> coord(0, 1);
+    std::vector<std::array<double, 3>> pts(500);
+    for(auto& p: pts)
+        for(auto& x: p)
+            x = coord(gen);
+    auto aligned = aligned_points(pts);
+    L2Metric metric;
+
+    GTPoints<3> G;
+    GTData aux;
+    fast_gt(greedy_tree(pts, metric).get(), G, aux);
+    GTPoints<3, AlignedPoint<3>> G_aligned;
+    GTData aux_aligned;
+    fast_gt(greedy_tree(aligned, metric).get(), G_aligned, aux_aligned);
+
+    // the same points in the same layout, only padded
+    ASSERT_EQ(G_aligned.size(), G.size());
+    for(size_t i = 0; i < G.size(); i++)
+        EXPECT_EQ(G_aligned[i].first, G[i].first);
+    EXPECT_EQ(aux_aligned, aux);
+
+    ApxNNSearch<3, L2Metric, AlignedPoint<3>> search(G_aligned, aux_aligned, metric);
+    AlignedPoint<3> q(std::array<double, 3>{0.5, 0.5, 0.5});
+    double best = std::numeric_limits<double>::max();
+    for(auto& p: pts)
+        best = std::min(best, metric.dist(p, q));
+    EXPECT_DOUBLE_EQ(metric.dist(G_aligned[search(q)].first, q), best);
+}